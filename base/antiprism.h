@@ -57,6 +57,7 @@
 #include "geometryinfo.h"
 #include "geometryutils.h"
 #include "getopt.h"
+#include "halfedges.h"
 #include "iteration.h"
 #include "mathutils.h"
 #include "normal.h"
@@ -67,6 +68,7 @@
 #include "scene.h"
 #include "status.h"
 #include "symmetry.h"
+#include "threadpool.h"
 #include "tiling.h"
 #include "timer.h"
 #include "trans3d.h"
@@ -75,6 +77,7 @@
 #include "vec3d.h"
 #include "vec4d.h"
 #include "vec_utils.h"
+#include "vertindex.h"
 #include "vrmlwriter.h"
 
 #endif // ANTIPRISM_H
@@ -63,8 +63,7 @@ static Status make_hull(Geometry &geom, bool append, string qh_args)
   vector<Vec3d> verts = geom.verts();
   Vec3d cent = geom.centroid();
 
-  map<int, Color> vcols;
-  vcols = geom.colors(VERTS).get_properties();
+  ElemProps<Color> vcols = geom.colors(VERTS);
 
   const int dim = 3;
   auto *points = new coordT[verts.size() * dim];
@@ -110,7 +109,7 @@ static Status make_hull(Geometry &geom, bool append, string qh_args)
       size_t idx = (vertex->point - points) / dim;
       vert_order[idx] = i++;
       int v_idx = geom.add_vert(verts[idx]);
-      geom.colors(VERTS).set(v_idx, vcols[idx]);
+      geom.colors(VERTS).set(v_idx, vcols.get(idx));
     }
   }
 
@@ -30,8 +30,11 @@
 
 #include "boundbox.h"
 #include "geometryinfo.h"
+#include "threadpool.h"
 #include "utils.h"
 
+#include <algorithm>
+
 using std::string;
 using std::vector;
 
@@ -144,6 +147,13 @@ Status make_planar_unit(Geometry &base_geom, IterationControl it_ctrl,
   vector<Vec3d> offsets(verts.size()); // Vertex adjustments
   vector<Vec3d> norms(faces.size());   // Face normals
   vector<Vec3d> cents(faces.size());   // Face centroids
+  AndersonAccel accel(it_ctrl.get_accel_depth());
+
+  // Faces and principal vertices are processed independently, in parts,
+  // and the result does not depend on the number of threads
+  ThreadPool pool(it_ctrl.get_num_threads());
+  const int num_parts = pool.get_num_threads();
+  vector<double> part_max_diff2(num_parts);
 
   double test_val = it_ctrl.get_test_val();
   double last_max_diff2 = 0.0;
@@ -157,10 +167,15 @@ Status make_planar_unit(Geometry &base_geom, IterationControl it_ctrl,
     }
 
     // Initialize face data for just the necessary faces
-    for (auto f_idx : faces_to_process) {
-      norms[f_idx] = geom.face_norm(f_idx).unit();
-      cents[f_idx] = geom.face_cent(f_idx);
-    }
+    pool.run(num_parts, [&](int part) {
+      const int sz = faces_to_process.size();
+      const int end = part_start(sz, num_parts, part + 1);
+      for (int i = part_start(sz, num_parts, part); i < end; i++) {
+        const int f_idx = faces_to_process[i];
+        norms[f_idx] = geom.face_norm(f_idx).unit();
+        cents[f_idx] = geom.face_cent(f_idx);
+      }
+    });
 
     Vec3d centroid = Vec3d::zero;
     if (using_symmetry) {
@@ -176,45 +191,57 @@ Status make_planar_unit(Geometry &base_geom, IterationControl it_ctrl,
       centroid = geom.centroid();
     }
 
-    double max_diff2 = 0.0;
-    for (auto v_idx : principal_verts) {
-      const auto &vfaces = vert_faces[v_idx];
-      const int vf_sz = vfaces.size();
-      // target vertex is centroid of projection of vertex onto planes
-      for (int f0 = 0; f0 < vf_sz; f0++) {
-        int f0_idx = vfaces[f0];
-        offsets[v_idx] +=
-            nearpoint_on_plane(verts[v_idx], cents[f0_idx], norms[f0_idx]);
-      }
-      offsets[v_idx] = (offsets[v_idx] / vf_sz - verts[v_idx]) * factor;
+    pool.run(num_parts, [&](int part) {
+      const int sz = principal_verts.size();
+      const int end = part_start(sz, num_parts, part + 1);
+      double max_diff2 = 0.0;
+      for (int p_idx = part_start(sz, num_parts, part); p_idx < end;
+           p_idx++) {
+        const int v_idx = principal_verts[p_idx];
+        const auto &vfaces = vert_faces[v_idx];
+        const int vf_sz = vfaces.size();
+        // target vertex is centroid of projection of vertex onto planes
+        for (int f0 = 0; f0 < vf_sz; f0++) {
+          int f0_idx = vfaces[f0];
+          offsets[v_idx] +=
+              nearpoint_on_plane(verts[v_idx], cents[f0_idx], norms[f0_idx]);
+        }
+        offsets[v_idx] = (offsets[v_idx] / vf_sz - verts[v_idx]) * factor;
 
-      // adjust for centroid
-      offsets[v_idx] -= centroid;
+        // adjust for centroid
+        offsets[v_idx] -= centroid;
 
-      // adjust for orthogonality
-      for (int i = 0; i < 2; i++) {
-        auto n = vcross(norms[vfaces[i + 2]], norms[vfaces[i]]).unit();
-        const auto v_ideal = nearpoint_on_plane(verts[v_idx], Vec3d::zero, n);
-        const auto offset = (v_ideal - verts[v_idx]) * factor * orth_mult;
-        offsets[v_idx] += offset;
-      }
+        // adjust for orthogonality
+        for (int i = 0; i < 2; i++) {
+          auto n = vcross(norms[vfaces[i + 2]], norms[vfaces[i]]).unit();
+          const auto v_ideal = nearpoint_on_plane(verts[v_idx], Vec3d::zero, n);
+          const auto offset = (v_ideal - verts[v_idx]) * factor * orth_mult;
+          offsets[v_idx] += offset;
+        }
 
-      // adjust for non-overlap
-      const auto &vfig = vert_figs[v_idx];
-      for (int i = 0; i < 4; i++) {
-        if (vtriple(verts[v_idx], verts[vfig[i]], verts[vfig[(i + 1) % 4]]) >
-            0) {
-          auto v_ideal = anti::centroid(
-              {verts[vfig[0]], verts[vfig[1]], verts[vfig[2]], verts[vfig[3]]});
-          offsets[v_idx] += (v_ideal - verts[v_idx]) * overlap_mult;
-          break;
+        // adjust for non-overlap
+        const auto &vfig = vert_figs[v_idx];
+        for (int i = 0; i < 4; i++) {
+          if (vtriple(verts[v_idx], verts[vfig[i]], verts[vfig[(i + 1) % 4]]) >
+              0) {
+            auto v_ideal = anti::centroid({verts[vfig[0]], verts[vfig[1]],
+                                           verts[vfig[2]], verts[vfig[3]]});
+            offsets[v_idx] += (v_ideal - verts[v_idx]) * overlap_mult;
+            break;
+          }
         }
+
+        auto diff2 = offsets[v_idx].len2();
+        if (diff2 > max_diff2)
+          max_diff2 = diff2;
       }
+      part_max_diff2[part] = max_diff2;
+    });
+    double max_diff2 =
+        *std::max_element(part_max_diff2.begin(), part_max_diff2.end());
 
-      auto diff2 = offsets[v_idx].len2();
-      if (diff2 > max_diff2)
-        max_diff2 = diff2;
-    }
+    // the test value is from the plain adjustments, accelerate afterwards
+    accel.update_offsets(verts, offsets, principal_verts);
 
     // adjust vertices post-loop
     if (using_symmetry) {
@@ -228,12 +255,15 @@ Status make_planar_unit(Geometry &base_geom, IterationControl it_ctrl,
     }
     else { // not using_symmetry
       // adjust all vertices
-      for (unsigned int i = 0; i < verts.size(); i++) {
-        auto new_v = verts[i] + offsets[i];
-        double new_v_len = new_v.len();
-        new_v *= 1 + (1 / new_v_len - 1) * unit_mult;
-        base_geom.raw_verts()[i] = new_v;
-      }
+      pool.run(num_parts, [&](int part) {
+        const int end = part_start(verts.size(), num_parts, part + 1);
+        for (int i = part_start(verts.size(), num_parts, part); i < end; i++) {
+          auto new_v = verts[i] + offsets[i];
+          double new_v_len = new_v.len();
+          new_v *= 1 + (1 / new_v_len - 1) * unit_mult;
+          base_geom.raw_verts()[i] = new_v;
+        }
+      });
     }
 
     // adjust plane factor
@@ -338,6 +368,7 @@ Status make_planar(Geometry &base_geom, IterationControl it_ctrl,
   vector<Vec3d> offsets(verts.size()); // Vertex adjustments
   vector<Vec3d> norms(faces.size());   // Face normals
   vector<Vec3d> cents(faces.size());   // Face centroids
+  AndersonAccel accel(it_ctrl.get_accel_depth());
 
   double test_val = it_ctrl.get_test_val();
   double last_max_diff2 = 0.0;
@@ -406,6 +437,9 @@ Status make_planar(Geometry &base_geom, IterationControl it_ctrl,
         max_diff2 = diff2;
     }
 
+    // the test value is from the plain adjustments, accelerate afterwards
+    accel.update_offsets(verts, offsets, principal_verts);
+
     // adjust vertices post-loop
     if (using_symmetry) {
       // adjust principal vertices
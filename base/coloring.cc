@@ -97,12 +97,14 @@ Coloring &Coloring::operator=(const Coloring &clrng)
 
 void Coloring::cycle_map_cols() { set_shift(get_shift() + 1); }
 
-void Coloring::set_all_idx_to_val(map<int, Color> &cols)
+void Coloring::set_all_idx_to_val(ElemProps<Color> &cols)
 {
-  map<int, Color>::iterator mi;
-  for (mi = cols.begin(); mi != cols.end(); mi++)
-    if (mi->second.is_index())
-      mi->second = get_col(mi->second.get_index());
+  vector<int> idxs;
+  for (const auto &kp : cols)
+    if (kp.second.is_index())
+      idxs.push_back(kp.first);
+  for (int idx : idxs)
+    cols.set(idx, get_col(cols.get(idx).get_index()));
 }
 
 inline double fract(double rng[], double frac)
@@ -175,7 +177,7 @@ Color Coloring::light(Vec3d vec, Geometry &lts)
 
 void Coloring::v_apply_cmap()
 {
-  set_all_idx_to_val(get_geom()->colors(VERTS).get_properties());
+  set_all_idx_to_val(get_geom()->colors(VERTS));
 }
 
 void Coloring::v_one_col(Color col)
@@ -289,7 +291,7 @@ void Coloring::v_lights(Geometry lts)
 
 void Coloring::f_apply_cmap()
 {
-  set_all_idx_to_val(get_geom()->colors(FACES).get_properties());
+  set_all_idx_to_val(get_geom()->colors(FACES));
 }
 
 void Coloring::f_one_col(Color col)
@@ -446,7 +448,7 @@ void Coloring::f_lights2(Geometry lts)
 
 void Coloring::e_apply_cmap()
 {
-  set_all_idx_to_val(get_geom()->colors(EDGES).get_properties());
+  set_all_idx_to_val(get_geom()->colors(EDGES));
 }
 
 void Coloring::e_one_col(Color col)
@@ -690,7 +692,8 @@ Status Coloring::apply_transparency(const int opacity, const int elem)
     ColorValuesToRangeHsva valmap(msg_str("A%g", (double)opacity / 255));
     valmap.apply(*get_geom(), elem);
 
-    for (const auto &kp : get_geom()->colors(elem).get_properties()) {
+    const ElemProps<Color> &elem_cols = get_geom()->colors(elem);
+    for (const auto &kp : elem_cols) {
       if (kp.second.is_index()) {
         warnings += "map indexes";
         break;
@@ -713,7 +716,7 @@ Status Coloring::apply_transparency(const int opacity, const int elem)
     }
 
     // check if some element colors are not set
-    if (get_geom()->colors(elem).get_properties().size() < sz) {
+    if ((unsigned int)elem_cols.size() < sz) {
       if (!warnings.empty())
         warnings += " and ";
       warnings += "unset " + elem_str;
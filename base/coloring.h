@@ -73,7 +73,7 @@ protected:
 
   /// Convert all colour index numbers into colour values.
   /**\param cols the colours of the elements, by element index. */
-  void set_all_idx_to_val(std::map<int, Color> &cols);
+  void set_all_idx_to_val(ElemProps<Color> &cols);
 
   /// Get the geometry that is being coloured.
   /**\return A pointer to the geometry. */
@@ -1740,6 +1740,15 @@ void ColorValuesToRangeHsva::apply(map<int, Color> &elem_cols)
     mi->second = get_col(mi->second);
 }
 
+void ColorValuesToRangeHsva::apply(ElemProps<Color> &elem_cols)
+{
+  vector<std::pair<int, Color>> cols;
+  for (const auto &kp : elem_cols)
+    cols.push_back(kp);
+  for (const auto &kp : cols)
+    elem_cols.set(kp.first, get_col(kp.second));
+}
+
 void ColorValuesToRangeHsva::apply(Geometry &geom, int elem_type)
 {
   if (default_color.is_set()) {
@@ -1759,7 +1768,7 @@ void ColorValuesToRangeHsva::apply(Geometry &geom, int elem_type)
     }
   }
   else {
-    apply(geom.colors(elem_type).get_properties());
+    apply(geom.colors(elem_type));
   }
 }
 
@@ -360,6 +360,10 @@ public:
   /**\param elem_cols element type to map colours for. */
   void apply(std::map<int, Color> &elem_cols);
 
+  /// Apply processing to colour values in an element property container
+  /**\param elem_cols element colours to map. */
+  void apply(ElemProps<Color> &elem_cols);
+
   /// Get the processed colour
   /**\param col the color.
    * \return The processed colour. */
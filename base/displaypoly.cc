@@ -28,6 +28,7 @@
 */
 
 #include "displaypoly.h"
+#include "geometryutils.h"
 #include "mathutils.h"
 #include "povwriter.h"
 #include "scene.h"
@@ -35,6 +36,8 @@
 #include "utils.h"
 #include "vrmlwriter.h"
 
+#include <algorithm>
+#include <array>
 #include <cstring>
 #include <map>
 #include <set>
@@ -50,7 +53,8 @@ namespace anti {
 
 DisplayPoly::DisplayPoly()
     : triangulate(true), winding_rule(TESS_WINDING_NONZERO), face_alpha(-1),
-      use_lines(false)
+      use_lines(false), use_mesh(false), use_inst_sym(false),
+      inst_sym_unused(false)
 {
 }
 
@@ -66,31 +70,36 @@ Color DisplayPoly::def_col(int type)
   return col.is_value() ? col : def_cols[type];
 }
 
-void DisplayPoly::geom_changed()
+void DisplayPoly::make_disp_geom(const Geometry &geom, Geometry &dgeom) const
 {
-  if (!sc_geom) // no geometry set
-    return;
-  disp_geom = sc_geom->get_geom();
+  dgeom = geom;
   vector<int> face_map;
   if (triangulate)
-    disp_geom.triangulate(Color::invisible, winding_rule, &face_map);
+    dgeom.triangulate(Color::invisible, winding_rule, &face_map);
   else {
-    face_map.resize(sc_geom->get_geom().faces().size());
+    face_map.resize(geom.faces().size());
     for (unsigned int i = 0; i < face_map.size(); i++)
       face_map[i] = i;
   }
-  face_map.push_back(disp_geom.faces().size()); // add end marker
+  face_map.push_back(dgeom.faces().size()); // add end marker
 
   if (face_alpha > 0) {
     for (unsigned int i = 0; i < face_map.size() - 1; i++) {
-      Color col = sc_geom->get_geom().colors(FACES).get(i);
+      Color col = geom.colors(FACES).get(i);
       col = Color(col[0], col[1], col[2], face_alpha < 256 ? face_alpha : 255);
       for (int f_idx = face_map[i]; f_idx < face_map[i + 1]; f_idx++)
-        disp_geom.colors(FACES).set(f_idx, col);
+        dgeom.colors(FACES).set(f_idx, col);
     }
   }
 }
 
+void DisplayPoly::geom_changed()
+{
+  if (!sc_geom) // no geometry set
+    return;
+  make_disp_geom(sc_geom->get_geom(), disp_geom);
+}
+
 void DisplayPoly::set_triangulate(bool tri)
 {
   if (triangulate != tri) {
@@ -133,6 +142,146 @@ int DisplayPoly::animate()
   return num_changes;
 }
 
+// --------------------------------------------------------------
+// DisplayPoly - symmetric instances
+
+// Find the transformations of a symmetry that carry the geometry onto
+// itself, with the identity first, and the element maps of each
+static bool get_instance_maps(const Geometry &geom, const Symmetry &sym,
+                              bool direct_only, vector<Trans3d> &trans,
+                              vector<vector<vector<int>>> &maps)
+{
+  trans.clear();
+  maps.clear();
+  CoincidenceMatcher matcher(geom, sym_eps);
+  if (!matcher.is_valid())
+    return false;
+
+  vector<vector<int>> elem_maps;
+  for (const auto &t : sym.get_trans()) {
+    if (direct_only && t.det() < 0)
+      continue;
+    if (!matcher.match(t, elem_maps))
+      continue;
+    trans.push_back(t);
+    maps.push_back(elem_maps);
+    if (compare(t, Trans3d::unit(), sym_eps) == 0) {
+      std::swap(trans.front(), trans.back());
+      std::swap(maps.front(), maps.back());
+    }
+  }
+
+  return trans.size() > 1 &&
+         compare(trans.front(), Trans3d::unit(), sym_eps) == 0;
+}
+
+// Divide the elements into parts, keyed by a list of transformations.
+// An element is in the part whose transformations carry it onto each
+// of the other elements of its orbit, if these all have the same colour,
+// otherwise the orbit elements are displayed individually.
+static void get_instance_parts(const Geometry &geom,
+                               const vector<vector<vector<int>>> &maps,
+                               map<vector<int>, vector<vector<int>>> &parts)
+{
+  parts.clear();
+  const vector<int> unit_only(1, 0);
+  for (int type : {VERTS, EDGES, FACES}) {
+    const int sz = maps[0][type].size();
+    vector<bool> done(sz, false);
+    vector<int> t_idxs;
+    vector<int> images;
+    for (int i = 0; i < sz; i++) {
+      if (done[i])
+        continue;
+      t_idxs.clear();
+      images.clear();
+      bool same_cols = true;
+      for (unsigned int t = 0; t < maps.size(); t++) {
+        const int img = maps[t][type][i];
+        if (find(images.begin(), images.end(), img) != images.end())
+          continue;
+        t_idxs.push_back(t);
+        images.push_back(img);
+        if (geom.colors(type).get(img) != geom.colors(type).get(i))
+          same_cols = false;
+      }
+
+      for (int img : images)
+        done[img] = true;
+      if (same_cols) {
+        auto &elems = parts[t_idxs];
+        elems.resize(3);
+        elems[type].push_back(i);
+      }
+      else {
+        auto &elems = parts[unit_only];
+        elems.resize(3);
+        elems[type].insert(elems[type].end(), images.begin(), images.end());
+      }
+    }
+  }
+}
+
+// Make a geometry from some elements, adding any vertices that are needed
+// for edges and faces as undisplayed vertices
+static Geometry get_part_geom(const Geometry &geom,
+                              const vector<vector<int>> &elems)
+{
+  Geometry part;
+  vector<int> v_map(geom.verts().size(), -1);
+  auto part_vert = [&](int v_idx) {
+    if (v_map[v_idx] < 0)
+      v_map[v_idx] = part.add_vert(geom.verts(v_idx), Color::invisible);
+    return v_map[v_idx];
+  };
+
+  for (int v_idx : elems[VERTS])
+    part.colors(VERTS).set(part_vert(v_idx), geom.colors(VERTS).get(v_idx));
+
+  for (int e_idx : elems[EDGES])
+    part.add_edge_raw({part_vert(geom.edges(e_idx, 0)),
+                       part_vert(geom.edges(e_idx, 1))},
+                      geom.colors(EDGES).get(e_idx));
+
+  for (int f_idx : elems[FACES]) {
+    vector<int> face;
+    for (int v_idx : geom.faces(f_idx))
+      face.push_back(part_vert(v_idx));
+    part.add_face(face, geom.colors(FACES).get(f_idx));
+  }
+
+  return part;
+}
+
+bool DisplayPoly::get_instances(vector<Geometry> &part_geoms,
+                                vector<vector<Trans3d>> &part_trans,
+                                bool direct_only) const
+{
+  part_geoms.clear();
+  part_trans.clear();
+  const Geometry &geom = sc_geom->get_geom();
+  Symmetry sym = inst_sym;
+  if (!sym.is_set())
+    sym.init(geom);
+
+  vector<Trans3d> trans;
+  vector<vector<vector<int>>> maps;
+  if (!get_instance_maps(geom, sym, direct_only, trans, maps))
+    return false;
+
+  map<vector<int>, vector<vector<int>>> parts;
+  get_instance_parts(geom, maps, parts);
+  for (const auto &part : parts) {
+    part_geoms.push_back(Geometry());
+    make_disp_geom(get_part_geom(geom, part.second), part_geoms.back());
+    part_trans.push_back(vector<Trans3d>());
+    for (int t_idx : part.first)
+      part_trans.back().push_back(trans[t_idx]);
+  }
+
+  return true;
+}
+
 // --------------------------------------------------------------
 // DisplayPoly - vrml
 
@@ -302,7 +451,7 @@ void DisplayPoly::vrml_verts(FILE *ofile, int sig_digits)
   fprintf(ofile, "# Vertex elements\n");
 
   const vector<Vec3d> &vs = disp_geom.verts();
-  for (unsigned int i = 0; i < sc_geom->get_geom().verts().size(); i++) {
+  for (unsigned int i = 0; i < vs.size(); i++) {
     if (disp_geom.colors(VERTS).get(i).is_invisible())
       continue;
     fprintf(ofile, "V_%s { C %s ",
@@ -463,14 +612,8 @@ void DisplayPoly::vrml_faces(FILE *ofile)
   fprintf(ofile, "\n\n\n");
 }
 
-void DisplayPoly::vrml_geom(FILE *ofile, const Scene &scen, int sig_digits)
+void DisplayPoly::vrml_elements(FILE *ofile, int sig_digits)
 {
-  if (disp_geom.verts().size() == 0) // Don't write out empty geometries
-    return;
-
-  vrml_protos(ofile);
-  vrml_translation_begin(ofile, scen);
-
   if (elem(FACES).get_show() || use_lines)
     vrml_coords(ofile, sig_digits);
   if (elem(VERTS).get_show()) {
@@ -487,6 +630,61 @@ void DisplayPoly::vrml_geom(FILE *ofile, const Scene &scen, int sig_digits)
   }
   if (elem(FACES).get_show())
     vrml_faces(ofile);
+}
+
+void DisplayPoly::vrml_instances(FILE *ofile, vector<Geometry> &part_geoms,
+                                 const vector<vector<Trans3d>> &part_trans,
+                                 int sig_digits)
+{
+  for (unsigned int i = 0; i < part_geoms.size(); i++) {
+    string part_name = msg_str("Part%s_%s_%u", get_id_label().c_str(),
+                               dots2underscores(sc_geom->get_name()).c_str(),
+                               i);
+    fprintf(ofile,
+            "# Part %u, displayed with %lu symmetry rotations\n"
+            "DEF %s Group {\n"
+            "   children [\n\n",
+            i, (unsigned long)part_trans[i].size(), part_name.c_str());
+    std::swap(disp_geom, part_geoms[i]);
+    vrml_elements(ofile, sig_digits);
+    std::swap(disp_geom, part_geoms[i]);
+    fprintf(ofile, "   ]\n"
+                   "}\n\n");
+
+    // the first transformation is the identity, used for the definition
+    for (unsigned int j = 1; j < part_trans[i].size(); j++) {
+      Isometry ax_ang(part_trans[i][j]);
+      Vec3d axis(0, 1, 0);
+      if (ax_ang.get_axis().is_set())
+        axis = ax_ang.get_axis();
+      fprintf(ofile,
+              "Transform { translation %s rotation %s %.*g "
+              "children [ USE %s ] }\n",
+              vrml_vec(ax_ang.get_transl(), sig_digits).c_str(),
+              vrml_vec(axis, sig_digits).c_str(), DEF_SIG_DGTS,
+              ax_ang.get_ang(), part_name.c_str());
+    }
+    fprintf(ofile, "\n\n");
+  }
+}
+
+void DisplayPoly::vrml_geom(FILE *ofile, const Scene &scen, int sig_digits)
+{
+  if (disp_geom.verts().size() == 0) // Don't write out empty geometries
+    return;
+
+  vrml_protos(ofile);
+  vrml_translation_begin(ofile, scen);
+
+  vector<Geometry> part_geoms;
+  vector<vector<Trans3d>> part_trans;
+  inst_sym_unused = false;
+  if (use_inst_sym && get_instances(part_geoms, part_trans, true))
+    vrml_instances(ofile, part_geoms, part_trans, sig_digits);
+  else {
+    inst_sym_unused = use_inst_sym;
+    vrml_elements(ofile, sig_digits);
+  }
 
   vrml_translation_end(ofile);
 }
@@ -698,72 +896,282 @@ void DisplayPoly::pov_col_maps(FILE *ofile)
           "   #declare face_tex_map = tex_map;\n\n");
 }
 
+// Loops to display the elements in the vertex, edge and face arrays
+static const char *pov_elem_loops =
+    "// Display vertex elements\n"
+    "#if(verts_show)\n"
+    "   #declare i=0;\n"
+    "   #while (i<num_verts)\n"
+    "      #declare col = NoColour;\n"
+    "      #ifdef (v_cols[i]) #declare col=v_cols[i]+<0,0,0,0>; #end\n"
+    "         #if (col.x!=0 | col.y!=0 | col.z!=0 | col.t!=1)\n"
+    "            disp_vertex(i, col)\n"
+    "         #end\n"
+    "      #declare i=i+1;\n"
+    "      #end\n"
+    "   #end // (verts_show)\n"
+    "\n"
+    "// Display edge elements\n"
+    "#if (edges_show)\n"
+    "   #declare i=0;\n"
+    "   #while (i<num_edges)\n"
+    "      #declare col = NoColour;\n"
+    "      #ifdef (e_cols[i]) #declare col=e_cols[i]+<0,0,0,0>; #end\n"
+    "         #if (col.x!=0 | col.y!=0 | col.z!=0 | col.t!=1)\n"
+    "            disp_edge(i, col)\n"
+    "         #end\n"
+    "      #declare i=i+1;\n"
+    "      #end\n"
+    "   #end // (edges_show)\n"
+    "\n"
+    "// Display face elements\n"
+    "#if (faces_show)\n"
+    "   #declare face_no=0;"
+    "   #declare idx=0;\n"
+    "   #while (face_no<num_faces)\n"
+    "      #declare col = NoColour;\n"
+    "      #ifdef (f_cols[face_no]) #declare col=f_cols[face_no]+<0,0,0,0>; "
+    "#end\n"
+    "         #if (col.x!=0 | col.y!=0 | col.z!=0 | col.t!=1)\n"
+    "            disp_face(face_no, idx, col)\n"
+    "         #end\n"
+    "      #declare idx = idx + faces[idx] + 1;\n"
+    "      #declare face_no=face_no+1;\n"
+    "      #end\n"
+    "   #end // (faces_show)\n"
+    "\n";
+
 void DisplayPoly::pov_object(FILE *ofile)
 {
-  fprintf(
-      ofile,
-      "#if (show)\n"
-      //"union {\n"
-      "#declare NoColour = <-1, -1, -1, 0>; // Indicates no colour has been set"
-      "// Display vertex elements\n"
-      "#if(verts_show)\n"
-      "   #declare i=0;\n"
-      "   #while (i<num_verts)\n"
-      "      #declare col = NoColour;\n"
-      "      #ifdef (v_cols[i]) #declare col=v_cols[i]+<0,0,0,0>; #end\n"
-      "         #if (col.x!=0 | col.y!=0 | col.z!=0 | col.t!=1)\n"
-      "            disp_vertex(i, col)\n"
-      "         #end\n"
-      "      #declare i=i+1;\n"
-      "      #end\n"
-      "   #end // (verts_show)\n"
-      "\n"
-      "// Display edge elements\n"
-      "#if (edges_show)\n"
-      "   #declare i=0;\n"
-      "   #while (i<num_edges)\n"
-      "      #declare col = NoColour;\n"
-      "      #ifdef (e_cols[i]) #declare col=e_cols[i]+<0,0,0,0>; #end\n"
-      "         #if (col.x!=0 | col.y!=0 | col.z!=0 | col.t!=1)\n"
-      "            disp_edge(i, col)\n"
-      "         #end\n"
-      "      #declare i=i+1;\n"
-      "      #end\n"
-      "   #end // (edges_show)\n"
-      "\n"
-      "// Display face elements\n"
-      "#if (faces_show)\n"
-      "   #declare face_no=0;"
-      "   #declare idx=0;\n"
-      "   #while (face_no<num_faces)\n"
-      "      #declare col = NoColour;\n"
-      "      #ifdef (f_cols[face_no]) #declare col=f_cols[face_no]+<0,0,0,0>; "
-      "#end\n"
-      "         #if (col.x!=0 | col.y!=0 | col.z!=0 | col.t!=1)\n"
-      "            disp_face(face_no, idx, col)\n"
-      "         #end\n"
-      "      #declare idx = idx + faces[idx] + 1;\n"
-      "      #declare face_no=face_no+1;\n"
-      "      #end\n"
-      "   #end // (faces_show)\n"
-      "\n"
-      "// Extra object\n"
-      "disp_extra()\n"
-      "\n"
-      //"}\n\n"
-      "#end // (show)\n");
+  fprintf(ofile,
+          "#if (show)\n"
+          //"union {\n"
+          "#declare NoColour = <-1, -1, -1, 0>; // Indicates no colour has "
+          "been set"
+          "%s"
+          "// Extra object\n"
+          "disp_extra()\n"
+          "\n"
+          //"}\n\n"
+          "#end // (show)\n",
+          pov_elem_loops);
+}
+
+// Declare a texture for each distinct colour of a type of element, and
+// set the texture name for each element, or an empty name if the element
+// is not displayed
+static void pov_mesh_texs(FILE *ofile, const Geometry &geom, int type,
+                          const Coloring &clrng, vector<string> &tex_names)
+{
+  const char *elem_names[] = {"vert", "edge", "face"};
+  const char *elem = elem_names[type];
+  const int num_elems = (type == VERTS)   ? geom.verts().size()
+                        : (type == EDGES) ? geom.edges().size()
+                                          : geom.faces().size();
+  map<string, string> texs;
+  tex_names.assign(num_elems, string());
+  for (int i = 0; i < num_elems; i++) {
+    Color col = geom.colors(type).get(i);
+    if (col.is_index())
+      col = clrng.get_col(col.get_index());
+    if (col.is_invisible())
+      continue;
+    string pcol = pov_col(col);
+    if (pcol.empty())
+      pcol = "NoColour";
+    auto ins = texs.insert(std::make_pair(pcol, string()));
+    if (ins.second) {
+      ins.first->second = msg_str("%s_tex_%lu", elem,
+                                  (unsigned long)texs.size() - 1);
+      fprintf(ofile,
+              "   #declare %s = col_to_tex(%s, %s_tex_map, %s_col_map, "
+              "%s_tex)\n",
+              ins.first->second.c_str(), pcol.c_str(), elem, elem, elem);
+    }
+    tex_names[i] = ins.first->second;
+  }
+}
+
+// Write objects as a union, or as a single object
+static void pov_union(FILE *ofile, const vector<string> &objs)
+{
+  if (objs.size() > 1)
+    fprintf(ofile, "   union {\n");
+  for (const auto &obj : objs)
+    fprintf(ofile, "      %s\n", obj.c_str());
+  if (objs.size() > 1)
+    fprintf(ofile, "   }\n");
+}
+
+void DisplayPoly::pov_mesh_elements(FILE *ofile, int sig_digits)
+{
+  const vector<Vec3d> &vs = disp_geom.verts();
+  const vector<vector<int>> &es = disp_geom.edges();
+  const vector<vector<int>> &fs = disp_geom.faces();
+  vector<string> tex_names;
+  vector<string> objs;
+
+  fprintf(ofile, "// Display vertex elements\n"
+                 "#if (verts_show)\n");
+  pov_mesh_texs(ofile, disp_geom, VERTS, clrngs[VERTS], tex_names);
+  for (unsigned int i = 0; i < vs.size(); i++)
+    if (!tex_names[i].empty())
+      objs.push_back(msg_str("sphere { verts[%u] vert_sz texture { %s } }",
+                             i, tex_names[i].c_str()));
+  pov_union(ofile, objs);
+  fprintf(ofile, "#end // (verts_show)\n\n");
+
+  fprintf(ofile, "// Display edge elements\n"
+                 "#if (edges_show)\n");
+  pov_mesh_texs(ofile, disp_geom, EDGES, clrngs[EDGES], tex_names);
+  objs.clear();
+  for (unsigned int i = 0; i < es.size(); i++)
+    if (!tex_names[i].empty() && compare(vs[es[i][0]], vs[es[i][1]], 0))
+      objs.push_back(msg_str("cylinder { verts[%d] verts[%d] edge_sz "
+                             "texture { %s } }",
+                             es[i][0], es[i][1], tex_names[i].c_str()));
+  pov_union(ofile, objs);
+  fprintf(ofile, "#end // (edges_show)\n\n");
+
+  fprintf(ofile, "// Display face elements\n"
+                 "#if (faces_show)\n");
+  pov_mesh_texs(ofile, disp_geom, FACES, clrngs[FACES], tex_names);
+  // Faces with more than three vertices are fanned from their centroid,
+  // as in disp_face_triangles
+  vector<Vec3d> mesh_verts = vs;
+  vector<std::array<int, 4>> tris; // vertex indexes and texture index
+  vector<string> tex_list;
+  map<string, int> tex_idxs;
+  for (unsigned int i = 0; i < fs.size(); i++) {
+    const vector<int> &face = fs[i];
+    if (tex_names[i].empty() || face.size() < 3)
+      continue;
+    auto ins =
+        tex_idxs.insert(std::make_pair(tex_names[i], (int)tex_list.size()));
+    if (ins.second)
+      tex_list.push_back(tex_names[i]);
+    const int tex_idx = ins.first->second;
+    if (face.size() == 3) {
+      tris.push_back({{face[0], face[1], face[2], tex_idx}});
+      continue;
+    }
+    const int cent_idx = mesh_verts.size();
+    mesh_verts.push_back(disp_geom.face_cent(i));
+    for (unsigned int j = 0; j < face.size(); j++)
+      tris.push_back(
+          {{cent_idx, face[j], face[(j + 1) % face.size()], tex_idx}});
+  }
+
+  if (tris.size()) {
+    fprintf(ofile, "   mesh2 {\n"
+                   "      vertex_vectors { %lu",
+            (unsigned long)mesh_verts.size());
+    for (const auto &v : mesh_verts)
+      fprintf(ofile, ",\n         %s", pov_vec(v, sig_digits).c_str());
+    fprintf(ofile, "\n      }\n"
+                   "      texture_list { %lu",
+            (unsigned long)tex_list.size());
+    for (const auto &tex : tex_list)
+      fprintf(ofile, ",\n         texture { %s }", tex.c_str());
+    fprintf(ofile, "\n      }\n"
+                   "      face_indices { %lu",
+            (unsigned long)tris.size());
+    for (const auto &tri : tris)
+      fprintf(ofile, ",\n         <%d, %d, %d>, %d", tri[0], tri[1], tri[2],
+              tri[3]);
+    fprintf(ofile, "\n      }\n"
+                   "   }\n");
+  }
+  fprintf(ofile, "#end // (faces_show)\n\n");
+}
+
+// POV matrix for a transformation, which is applied to row vectors
+static string pov_matrix(const Trans3d &trans, int sig_digits)
+{
+  string mat;
+  for (int i = 0; i < 4; i++) {
+    const string row =
+        pov_vec(trans[i], trans[i + 4], trans[i + 8], sig_digits);
+    mat += (i ? ", " : "<") + row.substr(1, row.size() - 2);
+  }
+  return mat + ">";
+}
+
+void DisplayPoly::pov_instances(FILE *ofile, vector<Geometry> &part_geoms,
+                                const vector<vector<Trans3d>> &part_trans,
+                                int sig_digits)
+{
+  pov_default_vals(ofile);
+  pov_disp_macros(ofile);
+  for (unsigned int i = 0; i < part_geoms.size(); i++) {
+    std::swap(disp_geom, part_geoms[i]);
+    pov_elements(ofile, sig_digits);
+    std::swap(disp_geom, part_geoms[i]);
+    if (i == 0) {
+      pov_col_maps(ofile);
+      pov_include_files(ofile);
+      fprintf(ofile, "#declare NoColour = <-1, -1, -1, 0>; // Indicates no "
+                     "colour has been set\n\n");
+    }
+
+    fprintf(ofile,
+            "// Part %u, displayed with %lu symmetry transformations\n"
+            "#if (show)\n"
+            "#declare sym_part = union {\n"
+            "%s",
+            i, (unsigned long)part_trans[i].size(),
+            use_mesh ? "" : pov_elem_loops);
+    if (use_mesh) {
+      std::swap(disp_geom, part_geoms[i]);
+      pov_mesh_elements(ofile, sig_digits);
+      std::swap(disp_geom, part_geoms[i]);
+    }
+    fprintf(ofile, "}\n");
+    for (const auto &trans : part_trans[i])
+      fprintf(ofile, "object { sym_part matrix %s }\n",
+              pov_matrix(trans, sig_digits).c_str());
+    fprintf(ofile, "#end // (show)\n\n");
+  }
+
+  fprintf(ofile, "#if (show)\n"
+                 "// Extra object\n"
+                 "disp_extra()\n"
+                 "#end // (show)\n");
 }
 
 void DisplayPoly::pov_geom(FILE *ofile, const Scene &, int sig_digits)
 {
   if (disp_geom.verts().size() == 0) // Don't write out empty geometries
     return;
+
+  vector<Geometry> part_geoms;
+  vector<vector<Trans3d>> part_trans;
+  inst_sym_unused = false;
+  if (use_inst_sym) {
+    if (get_instances(part_geoms, part_trans)) {
+      pov_instances(ofile, part_geoms, part_trans, sig_digits);
+      return;
+    }
+    inst_sym_unused = true;
+  }
+
   pov_default_vals(ofile);
   pov_disp_macros(ofile);
   pov_elements(ofile, sig_digits);
   pov_col_maps(ofile);
   pov_include_files(ofile);
-  pov_object(ofile);
+  if (use_mesh) {
+    fprintf(ofile, "#if (show)\n"
+                   "#declare NoColour = <-1, -1, -1, 0>; // Indicates no "
+                   "colour has been set\n\n");
+    pov_mesh_elements(ofile, sig_digits);
+    fprintf(ofile, "// Extra object\n"
+                   "disp_extra()\n"
+                   "\n"
+                   "#end // (show)\n");
+  }
+  else
+    pov_object(ofile);
 }
 
 #ifdef HAVE_CONFIG_H
@@ -1310,6 +1718,18 @@ void ViewOpts::set_view_vals(Scene &scen)
   }
 }
 
+void ViewOpts::warn_instance_sym_unused(const Scene &scen) const
+{
+  for (const auto &sgeom : scen.get_geoms())
+    for (const auto *disp : sgeom.get_disps()) {
+      auto poly_disp = dynamic_cast<const DisplayPoly *>(disp);
+      if (poly_disp && poly_disp->get_instance_sym_unused())
+        warning("symmetric parts not found for '" + sgeom.get_name() +
+                    "', all elements written",
+                'y');
+    }
+}
+
 const char *ViewOpts::help_view_text =
     "  -v <rad>  radius of vertex spheres, or 'b' to have radius of balls\n"
     "            of the maximum size without overlap (default: ball_rad/15)\n"
@@ -1446,6 +1866,16 @@ Status ViewOpts::read_disp_option(char opt, char *optarg)
     }
     break;
 
+  case 'y':
+    if (strcmp(optarg, "full") == 0)
+      get_geom_defs().set_instance_sym();
+    else {
+      Symmetry sym;
+      if ((stat = sym.init(optarg)))
+        get_geom_defs().set_instance_sym(sym);
+    }
+    break;
+
   case 't': {
     const char *params = "odd|nonzero|positive|negative|no_triangulation\n";
     string arg_id;
@@ -44,10 +44,19 @@ private:
   int face_alpha;
   bool use_lines;                    // vrml
   std::vector<std::string> includes; // pov
+  bool use_mesh;                     // pov
+  bool use_inst_sym;                 // write symmetric parts as instances
+  Symmetry inst_sym;                 // instance symmetry, unset to find
+  bool inst_sym_unused;              // all elements written, no instances
 
 protected:
   Geometry disp_geom;
 
+  void make_disp_geom(const Geometry &geom, Geometry &dgeom) const;
+  bool get_instances(std::vector<Geometry> &part_geoms,
+                     std::vector<std::vector<Trans3d>> &part_trans,
+                     bool direct_only = false) const;
+
   void vrml_trans_begin(FILE *ofile, const Scene &scene);
   void vrml_trans_end(FILE *ofile);
   void vrml_protos(FILE *ofile);
@@ -57,6 +66,10 @@ protected:
   void vrml_edges_l(FILE *ofile);
   void vrml_edges(FILE *ofile);
   void vrml_faces(FILE *ofile);
+  void vrml_elements(FILE *ofile, int sig_digits);
+  void vrml_instances(FILE *ofile, std::vector<Geometry> &part_geoms,
+                      const std::vector<std::vector<Trans3d>> &part_trans,
+                      int sig_digits);
 
   void pov_default_vals(FILE *ofile);
   void pov_disp_macros(FILE *ofile);
@@ -67,6 +80,10 @@ protected:
   void pov_col_maps(FILE *ofile);
   void pov_include_files(FILE *ofile);
   void pov_object(FILE *ofile);
+  void pov_mesh_elements(FILE *ofile, int sig_digits);
+  void pov_instances(FILE *ofile, std::vector<Geometry> &part_geoms,
+                     const std::vector<std::vector<Trans3d>> &part_trans,
+                     int sig_digits);
 
 public:
   DisplayPoly();
@@ -86,6 +103,22 @@ public:
   void set_includes(std::vector<std::string> incs) { includes = incs; }
   std::vector<std::string> &get_includes() { return includes; }
   const std::vector<std::string> &get_includes() const { return includes; }
+  // Write faces as a single mesh2, and vertices and edges as unions of
+  // spheres and cylinders, rather than with the display macros.
+  void set_use_mesh(bool mesh) { use_mesh = mesh; }
+  bool get_use_mesh() { return use_mesh; }
+
+  // Write one part of each set of elements repeated by a symmetry, and
+  // display it with the symmetry transformations. An unset symmetry
+  // uses the full symmetry of the model.
+  void set_instance_sym(const Symmetry &sym = Symmetry())
+  {
+    use_inst_sym = true;
+    inst_sym = sym;
+  }
+  // Check whether instances were set but could not be found for the
+  // model when it was last written, so all the elements were written.
+  bool get_instance_sym_unused() const { return inst_sym_unused; }
 
   Geometry &get_disp_geom() { return disp_geom; }
   GeometryDisplay *clone() const { return new DisplayPoly(*this); }
@@ -186,6 +219,7 @@ public:
   void set_geom_defs(const DisplayPoly &defs);
   void set_num_label_defs(const DisplayNumLabels &defs);
   void set_sym_defs(const DisplaySymmetry &defs);
+  void warn_instance_sym_unused(const Scene &scen) const;
   DisplayPoly &get_geom_defs() { return *geom_defs; }
 };
 
@@ -108,12 +108,11 @@ int orient_geom(Geometry &geom, vector<vector<int>> *parts)
 {
   int part_num = 0;
   const int done = -1;
-  auto edges = geom.get_edge_face_pairs(false);
+  // reversing faces does not change the faces on an edge
+  const HalfEdges hes(geom);
   vector<int> cur_idx(geom.faces().size(), 0);
   vector<int> prev_face(geom.faces().size(), 0);
-  vector<int> e_verts(2);
   vector<int> orig_e_verts(2);
-  vector<int> e_faces(2);
   for (unsigned int i = 0; i < geom.faces().size(); i++) {
     if (geom.faces(i).size() < 3)
       cur_idx[i] = done; // don't process degenerate faces
@@ -136,12 +135,12 @@ int orient_geom(Geometry &geom, vector<vector<int>> *parts)
       orig_e_verts[1] = face[idx];
       cur_idx[cur_fidx] = idx ? idx : done; // set to next idx, or mark done
 
-      e_verts = orig_e_verts;
-      if (e_verts[0] > e_verts[1])
-        swap(e_verts[0], e_verts[1]);
-      e_faces = edges.find(e_verts)->second;
-
-      int next_face = (e_faces[0] != cur_fidx) ? e_faces[0] : e_faces[1];
+      const int e_idx = hes.find_edge(orig_e_verts[0], orig_e_verts[1]);
+      const int f0 = hes.face(hes.edge_half_edge(e_idx, 0));
+      const int f1 = (hes.edge_size(e_idx) > 1)
+                         ? hes.face(hes.edge_half_edge(e_idx, 1))
+                         : -1;
+      int next_face = (f0 != cur_fidx) ? f0 : f1;
       if (next_face >= 0 && cur_idx[next_face] == 0) { // face not looked at yet
         orient_face(geom.raw_faces()[next_face], orig_e_verts[1],
                     orig_e_verts[0]);
@@ -228,33 +227,29 @@ void get_dual(Geometry &dual, const Geometry &geom, double recip_rad,
   get_pol_recip_verts(dual, geom, recip_rad, centre, inf);
   vector<vector<int>> d_faces(geom.verts().size());
 
-  const vector<vector<int>> &faces = geom.faces();
-  map<pair<int, int>, pair<int, int>> edges;
-  map<pair<int, int>, pair<int, int>>::iterator mi;
-  pair<int, int> edge;
-  for (unsigned int i = 0; i < faces.size(); ++i) {
-    for (unsigned int j = 0; j < faces[i].size(); ++j) {
-      edge.first = faces[i][j];
-      edge.second = faces[i][(j + 1) % faces[i].size()];
-      bool swap_idxs = (edge.first > edge.second);
-      if (swap_idxs)
-        swap(edge.first, edge.second);
-      mi = edges.find(edge);
-      if (mi != edges.end()) {
-        mi->second.second = i;
-        if (swap_idxs)
-          swap(mi->second.first, mi->second.second);
-      }
-      else
-        edges[edge].first = i;
+  // faces on either side of each edge, later faces replacing earlier ones
+  const auto hes_ptr = geom.get_half_edges();
+  const HalfEdges &hes = *hes_ptr;
+  const int e_sz = hes.num_edges();
+  vector<pair<int, int>> e_faces(e_sz);
+  for (int e_idx = 0; e_idx < e_sz; e_idx++) {
+    pair<int, int> &e_fs = e_faces[e_idx];
+    e_fs.first = hes.face(hes.edge_half_edge(e_idx, 0));
+    e_fs.second = 0;
+    for (int n = 1; n < hes.edge_size(e_idx); n++) {
+      const int he = hes.edge_half_edge(e_idx, n);
+      e_fs.second = hes.face(he);
+      if (hes.vert(he) > hes.end_vert(he))
+        swap(e_fs.first, e_fs.second);
     }
   }
 
-  for (mi = edges.begin(); mi != edges.end(); mi++) {
-    d_faces[mi->first.first].push_back(mi->second.first);
-    d_faces[mi->first.first].push_back(mi->second.second);
-    d_faces[mi->first.second].push_back(mi->second.second);
-    d_faces[mi->first.second].push_back(mi->second.first);
+  for (int e_idx = 0; e_idx < e_sz; e_idx++) {
+    const pair<int, int> &e_fs = e_faces[e_idx];
+    d_faces[hes.edge_vert(e_idx, 0)].push_back(e_fs.first);
+    d_faces[hes.edge_vert(e_idx, 0)].push_back(e_fs.second);
+    d_faces[hes.edge_vert(e_idx, 1)].push_back(e_fs.second);
+    d_faces[hes.edge_vert(e_idx, 1)].push_back(e_fs.first);
   }
 
   vector<int>::iterator vi;
@@ -280,20 +275,23 @@ void get_dual(Geometry &dual, const Geometry &geom, double recip_rad,
   const vector<vector<int>> &g_edges = geom.edges();
   dual.colors(FACES) = geom.colors(VERTS);
   dual.colors(VERTS) = geom.colors(FACES);
-  vector<int> g_edge(2);
+  // first explicit edge matching each face edge
+  vector<int> g_idxs(e_sz, -1);
+  for (int i = 0; i < (int)g_edges.size(); i++) {
+    const vector<int> &g_edge = g_edges[i];
+    if (g_edge.size() == 2 && g_edge[0] <= g_edge[1]) {
+      const int e_idx = hes.find_edge(g_edge[0], g_edge[1]);
+      if (e_idx >= 0 && g_idxs[e_idx] < 0)
+        g_idxs[e_idx] = i;
+    }
+  }
   vector<int> d_edge(2);
-  for (mi = edges.begin(); mi != edges.end(); mi++) {
-    g_edge[0] = mi->first.first;
-    g_edge[1] = mi->first.second;
-    d_edge[0] = mi->second.first;
-    d_edge[1] = mi->second.second;
-    int gidx, didx;
-    vector<vector<int>>::const_iterator ei;
-    ei = find(g_edges.begin(), g_edges.end(), g_edge);
-    if (ei != g_edges.end()) {
-      gidx = ei - g_edges.begin();
-      didx = dual.add_edge(d_edge);
-      dual.colors(EDGES).set(didx, geom.colors(EDGES).get(gidx));
+  for (int e_idx = 0; e_idx < e_sz; e_idx++) {
+    if (g_idxs[e_idx] >= 0) {
+      d_edge[0] = e_faces[e_idx].first;
+      d_edge[1] = e_faces[e_idx].second;
+      int didx = dual.add_edge(d_edge);
+      dual.colors(EDGES).set(didx, geom.colors(EDGES).get(g_idxs[e_idx]));
     }
   }
 
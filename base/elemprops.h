@@ -32,15 +32,82 @@
 #include "color.h"
 
 #include <map>
+#include <utility>
+#include <vector>
 
 namespace anti {
 
+/// Element property container
+/** Properties are held in a map while few elements have a property, and
+ *  in an array indexed by element, with a flag for each element that has
+ *  a property, when most elements have a property. The representation is
+ *  changed automatically as properties are set and deleted. */
 template <class T> class ElemProps {
 private:
-  // Element index to element propert mapping
-  std::map<int, T> ElemProps;
+  std::map<int, T> props; // element index to property, when sparse
+
+  bool dense;                // properties are held in the arrays
+  std::vector<T> dense_vals; // property of each element, when dense
+  std::vector<bool> has_val; // whether each element has a property
+  int dense_cnt;             // number of elements with a property
+  int dense_min_cnt;         // no dense change below this number of elements
+
+  // whether cnt properties in an index range of size rng should be dense
+  bool use_dense(int cnt, int rng) const
+  {
+    return cnt >= 16 && cnt >= dense_min_cnt && 2 * cnt >= rng;
+  }
+  // whether cnt properties in an index range of size rng should be sparse
+  static bool use_sparse(int cnt, int rng) { return 8 * cnt < rng; }
+
+  void to_dense();
+  void to_sparse();
 
 public:
+  /// Iterator over the element properties, in element index order
+  /** Dereferences to a pair of the element index and a copy of its
+   *  property. Invalidated by any change to the properties. */
+  class const_iterator {
+  private:
+    const ElemProps *eprops;
+    typename std::map<int, T>::const_iterator mi; // when sparse
+    int idx;                                      // when dense
+
+    friend class ElemProps;
+    const_iterator(const ElemProps *eps,
+                   typename std::map<int, T>::const_iterator m_it, int i)
+        : eprops(eps), mi(m_it), idx(i)
+    {
+    }
+
+  public:
+    std::pair<int, T> operator*() const
+    {
+      if (eprops->dense)
+        return std::make_pair(idx, eprops->dense_vals[idx]);
+      return std::make_pair(mi->first, mi->second);
+    }
+    const_iterator &operator++()
+    {
+      if (eprops->dense) {
+        const int sz = eprops->has_val.size();
+        while (++idx < sz && !eprops->has_val[idx]) {
+        }
+      }
+      else
+        ++mi;
+      return *this;
+    }
+    bool operator==(const const_iterator &it) const
+    {
+      return mi == it.mi && idx == it.idx;
+    }
+    bool operator!=(const const_iterator &it) const { return !(*this == it); }
+  };
+
+  /// Constructor
+  ElemProps() : dense(false), dense_cnt(0), dense_min_cnt(0) {}
+
   /// Set an element property.
   /**\param idx the element index number.
    * \param prop the property to set. */
@@ -55,15 +122,34 @@ public:
    * \return The property. */
   T get(int idx) const;
 
+  /// Get the number of elements with a property
+  /**\return The number of elements. */
+  int size() const;
+
   /// Clear all element properties.
   void clear();
 
-  /// Get the properties map
-  /**\return The properties map. */
-  const std::map<int, T> &get_properties() const;
+  /// Get an iterator to the first element with a property
+  /**\return The iterator. */
+  const_iterator begin() const;
+
+  /// Get an iterator past the last element with a property
+  /**\return The iterator. */
+  const_iterator end() const;
+
+  /// Get a copy of the properties map
+  /** Iterating over the properties with \c begin() and \c end() does not
+   *  make a copy.
+   * \return The properties map. */
+  std::map<int, T> get_properties() const;
 
   /// Get the properties map
-  /**\return The properties map. */
+  /** The properties are held sparsely after this call, so that changes
+   *  made through the map are kept, and stay sparse until the number of
+   *  elements with a property has doubled. A later \c set() that makes
+   *  them dense again leaves the map empty, so do not keep the reference
+   *  across calls to \c set(), and prefer \c get() and \c set().
+   * \return The properties map. */
   std::map<int, T> &get_properties();
 
   /// Map properties to different index numbers.
@@ -106,51 +192,182 @@ public:
 
 // Implementation
 
+template <class T> void ElemProps<T>::to_dense()
+{
+  const int rng = props.size() ? props.rbegin()->first + 1 : 0;
+  dense_vals.assign(rng, T());
+  has_val.assign(rng, false);
+  for (const auto &kp : props) {
+    dense_vals[kp.first] = kp.second;
+    has_val[kp.first] = true;
+  }
+  dense_cnt = props.size();
+  dense_min_cnt = 0;
+  dense = true;
+  props.clear();
+}
+
+template <class T> void ElemProps<T>::to_sparse()
+{
+  props.clear();
+  for (int i = 0; i < (int)has_val.size(); i++)
+    if (has_val[i])
+      props.emplace_hint(props.end(), i, dense_vals[i]);
+  dense_vals.clear();
+  dense_vals.shrink_to_fit();
+  has_val.clear();
+  has_val.shrink_to_fit();
+  dense_cnt = 0;
+  dense = false;
+}
+
 template <class T> void ElemProps<T>::set(int idx, const T &prop)
 {
-  if (prop.is_set())
-    ElemProps[idx] = prop;
-  else
+  if (!prop.is_set()) {
     del(idx);
+    return;
+  }
+
+  if (dense) {
+    if (idx < 0)
+      to_sparse();
+    else if (idx >= (int)dense_vals.size()) {
+      if (use_sparse(dense_cnt + 1, idx + 1))
+        to_sparse();
+      else {
+        dense_vals.resize(idx + 1);
+        has_val.resize(idx + 1, false);
+      }
+    }
+  }
+
+  if (dense) {
+    if (!has_val[idx]) {
+      has_val[idx] = true;
+      dense_cnt++;
+    }
+    dense_vals[idx] = prop;
+  }
+  else {
+    props[idx] = prop;
+    if (props.begin()->first >= 0 &&
+        use_dense(props.size(), props.rbegin()->first + 1))
+      to_dense();
+  }
 }
 
-template <class T> void ElemProps<T>::del(int idx) { ElemProps.erase(idx); }
+template <class T> void ElemProps<T>::del(int idx)
+{
+  if (dense) {
+    if (idx >= 0 && idx < (int)has_val.size() && has_val[idx]) {
+      has_val[idx] = false;
+      dense_vals[idx] = T();
+      dense_cnt--;
+      if (use_sparse(dense_cnt, dense_vals.size()))
+        to_sparse();
+    }
+  }
+  else
+    props.erase(idx);
+}
 
 template <class T> T ElemProps<T>::get(int idx) const
 {
-  auto mi = ElemProps.find(idx);
-  if (mi != ElemProps.end())
+  if (dense)
+    return (idx >= 0 && idx < (int)has_val.size() && has_val[idx])
+               ? dense_vals[idx]
+               : T();
+
+  auto mi = props.find(idx);
+  if (mi != props.end())
     return mi->second;
   else
     return T();
 }
 
-template <class T> void ElemProps<T>::clear() { ElemProps.clear(); }
+template <class T> int ElemProps<T>::size() const
+{
+  return dense ? dense_cnt : props.size();
+}
+
+template <class T> void ElemProps<T>::clear()
+{
+  props.clear();
+  dense_vals.clear();
+  has_val.clear();
+  dense_cnt = 0;
+  dense_min_cnt = 0;
+  dense = false;
+}
 
-template <class T> const std::map<int, T> &ElemProps<T>::get_properties() const
+template <class T>
+typename ElemProps<T>::const_iterator ElemProps<T>::begin() const
+{
+  if (!dense)
+    return const_iterator(this, props.begin(), 0);
+  const_iterator it(this, props.end(), -1);
+  return ++it;
+}
+
+template <class T>
+typename ElemProps<T>::const_iterator ElemProps<T>::end() const
 {
-  return ElemProps;
+  return const_iterator(this, props.end(), dense ? (int)has_val.size() : 0);
+}
+
+template <class T> std::map<int, T> ElemProps<T>::get_properties() const
+{
+  if (!dense)
+    return props;
+  std::map<int, T> prop_map;
+  for (const auto &kp : *this)
+    prop_map.emplace_hint(prop_map.end(), kp.first, kp.second);
+  return prop_map;
 }
 
 template <class T> std::map<int, T> &ElemProps<T>::get_properties()
 {
-  return ElemProps;
+  if (dense) {
+    to_sparse();
+    // stay sparse while the map may still be in use, until enough
+    // properties have been set to pay for another change
+    dense_min_cnt = 2 * props.size();
+  }
+  return props;
 }
 
 template <class T> void ElemProps<T>::remap(const std::map<int, int> &chg_map)
 {
   if (!chg_map.size())
     return;
-  std::map<int, T> new_props;
-  for (const auto &kp : chg_map) {
-    if (kp.second != -1) {
-      auto cmi = ElemProps.find(kp.first);
-      if (cmi != ElemProps.end())
-        new_props[kp.second] = cmi->second;
+
+  // Collect the kept properties, both lists are in old index order
+  std::vector<std::pair<int, T>> new_props;
+  if (dense) {
+    for (const auto &kp : chg_map)
+      if (kp.second != -1 && kp.first >= 0 &&
+          kp.first < (int)has_val.size() && has_val[kp.first])
+        new_props.push_back(std::make_pair(kp.second, dense_vals[kp.first]));
+  }
+  else {
+    auto mi = props.begin();
+    for (const auto &kp : chg_map) {
+      while (mi != props.end() && mi->first < kp.first)
+        ++mi;
+      if (mi == props.end())
+        break;
+      if (kp.second != -1 && mi->first == kp.first)
+        new_props.push_back(std::make_pair(kp.second, mi->second));
     }
   }
 
-  ElemProps = new_props;
+  clear();
+  for (const auto &kp : new_props) // new index numbers are usually in order
+    props.emplace_hint(props.end(), kp.first, kp.second)->second =
+        kp.second;
+  if (props.size() && props.begin()->first >= 0 &&
+      use_dense(props.size(), props.rbegin()->first + 1))
+    to_dense();
 }
 
 template <class T>
@@ -176,8 +393,7 @@ void GeomElemProps<T>::append(const GeomElemProps &geom_props, int v_size,
 {
   int offs[] = {v_size, e_size, f_size};
   for (int i = 0; i < 3; i++) {
-    std::map<int, Color>::const_iterator mi;
-    for (const auto &pk : geom_props[i].get_properties())
+    for (const auto &pk : geom_props[i])
       elem_props[i].set(pk.first + offs[i], pk.second);
   }
 }
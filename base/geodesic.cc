@@ -30,16 +30,17 @@
 #include "mathutils.h"
 #include "private_geodesic.h"
 #include "private_misc.h"
+#include "threadpool.h"
 
 #include <algorithm>
 #include <cctype>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#include <map>
+#include <utility>
 #include <vector>
 
-using std::map;
 using std::swap;
 using std::vector;
 
@@ -64,7 +65,7 @@ void min_idx_first(vector<int> &tri)
   rotate(tri.begin(), tri.begin() + first, tri.end());
 }
 
-inline int_pr Geodesic::normal_crds(int_pr crds)
+inline int_pr Geodesic::normal_crds(int_pr crds) const
 {
   int_pr n_crds;
   if (crds.second < 0)
@@ -79,8 +80,12 @@ inline int_pr Geodesic::normal_crds(int_pr crds)
 
 inline int Geodesic::get_edge_index(int v0, int v1)
 {
-  auto mi = edge_idx.find(make_edge(v0, v1));
-  return (mi != edge_idx.end()) ? mi->second : -1;
+  if (v0 > v1)
+    swap(v0, v1);
+  for (int i = vert_edge_starts[v0]; i < vert_edge_starts[v0 + 1]; i++)
+    if (vert_edges[i].first == v1)
+      return vert_edges[i].second;
+  return -1;
 }
 
 vector<int> Geodesic::make_face_indexes(int i, const vector<int> &face)
@@ -96,7 +101,8 @@ vector<int> Geodesic::make_face_indexes(int i, const vector<int> &face)
   return indx;
 }
 
-inline int Geodesic::index_map(int i, int j, const vector<int> &indx, int p_idx)
+inline int Geodesic::index_map(int i, int j, const vector<int> &indx,
+                                int p_idx) const
 {
   IJPos pos = get_pos(i, j);
   // polyhedron vertex
@@ -138,12 +144,11 @@ inline int Geodesic::index_map(int i, int j, const vector<int> &indx, int p_idx)
   // polyhedron face interior
   if (pos.is_face()) {
     if (p_idx == noindex) {
-      auto mi = grid_idxs.find(int_pr(i, j));
-      if (mi == grid_idxs.end()) {
-        // fprintf(stderr, "not found in grid_idxs i=%d, j=%d\n", i, j);
+      if (i < 0 || j < 0 || i >= grid_sz || j >= grid_sz)
+        return noindex;
+      p_idx = grid_idxs[i * grid_sz + j];
+      if (p_idx == noindex)
         return noindex;
-      }
-      p_idx = mi->second;
     }
     int indx_no = V_sz + (F - 1) * base.edges().size() +
                   (F * F * (m * m + m * n + n * n) - F * 3 + 2) / 2 * indx[6] +
@@ -152,29 +157,18 @@ inline int Geodesic::index_map(int i, int j, const vector<int> &indx, int p_idx)
   }
 
   if (pos.is_out()) {
-    vector<int> edge(2);
-    if (y < 0) {
-      edge[0] = indx[0];
-      edge[1] = indx[1];
-    }
-    else if (x + y > freq) {
-      edge[0] = indx[1];
-      edge[1] = indx[2];
-    }
-    else { // x<0
-      edge[0] = indx[2];
-      edge[1] = indx[0];
-    }
-
-    int nf_pos = 1;
-    if (edge[0] > edge[1]) {
-      swap(edge[0], edge[1]);
-      nf_pos = 0;
-    }
-
-    auto mi_ef = edge_faces.find(edge);
-    int nf_idx = mi_ef->second[nf_pos]; // index of neighbouring face
-    if (nf_idx == -1)                   // no neighbouring face
+    int e_pos; // position of the crossed edge in indx
+    if (y < 0)
+      e_pos = 0;
+    else if (x + y > freq)
+      e_pos = 1;
+    else // x<0
+      e_pos = 2;
+
+    // the neighbouring face is on the other side of the edge
+    int nf_pos = indx[e_pos] < indx[(e_pos + 1) % 3];
+    int nf_idx = edge_faces[indx[3 + e_pos]][nf_pos]; // neighbouring face
+    if (nf_idx == -1)                                  // no neighbouring face
       return noindex;
 
     const vector<int> &nface = base.faces()[nf_idx];
@@ -195,8 +189,7 @@ inline int Geodesic::index_map(int i, int j, const vector<int> &indx, int p_idx)
     // if(n_crds.second < n/2)
     //   return noindex;
 
-    vector<int> n_indx = make_face_indexes(nf_idx, nface);
-    return index_map(coord_i(n_crds), coord_j(n_crds), n_indx);
+    return index_map(coord_i(n_crds), coord_j(n_crds), face_indxs[nf_idx]);
   }
 
   return noindex; // should never get here!
@@ -204,7 +197,8 @@ inline int Geodesic::index_map(int i, int j, const vector<int> &indx, int p_idx)
 
 Geodesic::Geodesic(const Geometry &base_poly, int mm, int nn, char mthd,
                    Vec3d cen)
-    : base(base_poly), m(mm), n(nn), method(mthd), centre(cen)
+    : base(base_poly), m(mm), n(nn), method(mthd), centre(cen),
+      num_threads(1)
 {
   init();
 }
@@ -221,20 +215,48 @@ void Geodesic::init()
   triangulate_basic(base, false, 0);
   base.add_missing_impl_edges();
   for (unsigned int i = 0; i < base.faces().size(); i++) {
-    min_idx_first(base.faces(i));
+    min_idx_first(base.raw_faces(i));
   }
 
-  for (unsigned int i = 0; i < base.edges().size(); i++)
-    edge_idx[base.edges(i)] = i;
-
-  // fprintf(stderr, "edges.size()=%d\n", edges.size());
-  edge_faces = base.get_edge_face_pairs();
-  map<vector<int>, vector<int>>::iterator mi;
+  make_edge_tables();
 
   F = freq / (m * m + m * n + n * n);
   make_grid_idxs();
 }
 
+void Geodesic::make_edge_tables()
+{
+  const vector<vector<int>> &edges = base.edges();
+  vert_edge_starts.assign(base.verts().size() + 1, 0);
+  for (const auto &edge : edges)
+    vert_edge_starts[std::min(edge[0], edge[1]) + 1]++;
+  for (unsigned int i = 1; i < vert_edge_starts.size(); i++)
+    vert_edge_starts[i] += vert_edge_starts[i - 1];
+
+  vert_edges.resize(edges.size());
+  vector<int> next(vert_edge_starts.begin(), vert_edge_starts.end() - 1);
+  for (unsigned int i = 0; i < edges.size(); i++) {
+    const int v0 = std::min(edges[i][0], edges[i][1]);
+    const int v1 = std::max(edges[i][0], edges[i][1]);
+    vert_edges[next[v0]++] = int_pr(v1, i);
+  }
+
+  // a later face on the same side of an edge replaces an earlier one,
+  // and the last face including an edge sets its points
+  edge_faces.assign(edges.size(), {{-1, -1}});
+  edge_owners.assign(edges.size(), -1);
+  face_indxs.resize(base.faces().size());
+  for (unsigned int i = 0; i < base.faces().size(); i++) {
+    const vector<int> &face = base.faces(i);
+    face_indxs[i] = make_face_indexes(i, face);
+    for (int j = 0; j < 3; j++) {
+      const int e_idx = face_indxs[i][3 + j];
+      edge_faces[e_idx][face[j] > face[(j + 1) % 3]] = i;
+      edge_owners[e_idx] = i;
+    }
+  }
+}
+
 void clear_def_edges(Geometry &geom)
 {
   vector<int> del_edges;
@@ -266,39 +288,65 @@ void Geodesic::make_geo(Geometry &geo)
 
   gverts.resize(num_verts);
 
+  // Each base face sets its interior points and the points of the edges
+  // it owns, so the faces are filled independently. They are filled in
+  // chunks, and the triangles of a chunk are added in face order, which
+  // limits the memory held for triangles not yet added.
+  const int num_faces = base.faces().size();
+  ThreadPool pool(num_threads);
+  const int chunk_sz = 4 * pool.get_num_threads();
+  vector<vector<vector<int>>> face_tris(chunk_sz);
+  vector<vector<vector<int>>> face_orig_edges(chunk_sz);
+  vector<vector<int>> &gfaces = geo.raw_faces();
   vector<vector<int>> orig_edges;
-  for (unsigned int i = 0; i < base.faces().size(); i++) {
-    vector<int> indx = make_face_indexes(i, base.faces(i));
-    grid_to_points(indx, gverts);
-    vector<vector<int>> new_face_tris;
-    grid_to_tris(indx, new_face_tris, orig_edges);
-    vector<vector<int>> &gfaces = geo.raw_faces();
-    gfaces.insert(gfaces.end(), new_face_tris.begin(), new_face_tris.end());
-    Color f_col = base.colors(FACES).get(int(i));
-    for (unsigned int f = gfaces.size() - new_face_tris.size();
-         f < gfaces.size(); f++)
-      geo.colors(FACES).set(int(f), f_col);
+  for (int start = 0; start < num_faces; start += chunk_sz) {
+    const int num_chunk_faces = std::min(chunk_sz, num_faces - start);
+    pool.run(num_chunk_faces, [&](int i) {
+      const vector<int> &indx = face_indxs[start + i];
+      grid_to_points(indx, gverts);
+      grid_to_tris(indx, face_tris[i], face_orig_edges[i]);
+    });
+
+    for (int i = 0; i < num_chunk_faces; i++) {
+      Color f_col = base.colors(FACES).get(start + i);
+      for (auto &tri : face_tris[i]) {
+        gfaces.push_back(std::move(tri));
+        geo.colors(FACES).set(int(gfaces.size()) - 1, f_col);
+      }
+      face_tris[i].clear();
+      orig_edges.insert(orig_edges.end(), face_orig_edges[i].begin(),
+                        face_orig_edges[i].end());
+      face_orig_edges[i].clear();
+    }
   }
 
   geo.add_missing_impl_edges();
-  // fprintf(stderr, "orig_edges.size()= %d\n", orig_edges.size());
-  for (auto &orig_edge : orig_edges) {
-    vector<int> edge(2);
-    edge[0] = orig_edge[0];
-    edge[1] = orig_edge[1];
+  if (orig_edges.size()) {
+    // find edges by packed vertex index pair, the first of equal edges
     const vector<vector<int>> &gedges = geo.edges();
-    int e_idx = find(gedges.begin(), gedges.end(), edge) - gedges.begin();
-    Color e_col = base.colors(EDGES).get(orig_edge[2]);
-    geo.colors(EDGES).set(e_idx, e_col);
-    // fprintf(stderr, "adding edge (%d, %d) col=%s\n", edge[0], edge[1],
-    // e_col.get_Vec4d().to_str());
+    vector<std::pair<uint64_t, int>> edge_keys(gedges.size());
+    for (unsigned int i = 0; i < gedges.size(); i++)
+      edge_keys[i] = std::make_pair(
+          (uint64_t)gedges[i][0] << 32 | (uint32_t)gedges[i][1], (int)i);
+    sort(edge_keys.begin(), edge_keys.end());
+    for (auto &orig_edge : orig_edges) {
+      const uint64_t key =
+          (uint64_t)orig_edge[0] << 32 | (uint32_t)orig_edge[1];
+      auto ki = lower_bound(edge_keys.begin(), edge_keys.end(),
+                            std::make_pair(key, 0));
+      if (ki == edge_keys.end() || ki->first != key)
+        continue;
+      Color e_col = base.colors(EDGES).get(orig_edge[2]);
+      geo.colors(EDGES).set(ki->second, e_col);
+    }
   }
   clear_def_edges(geo);
 }
 
-void Geodesic::grid_to_points(vector<int> indx, vector<Vec3d> &gverts)
+void Geodesic::grid_to_points(const vector<int> &indx,
+                              vector<Vec3d> &gverts) const
 {
-  const vector<int> face = base.faces(indx[6]);
+  const vector<int> &face = base.faces(indx[6]);
   // fprintf(stderr, "\n+++++++\t\t\t\tface %d = (%d, %d, %d)\n", indx[6],
   // face[0], face[1], face[2]);
 
@@ -344,6 +392,13 @@ void Geodesic::grid_to_points(vector<int> indx, vector<Vec3d> &gverts)
       if (pos.is_out() || pos.is_vert())
         continue;
 
+      // edge points are set by the owning face only
+      if (pos.is_edge()) {
+        int e_pos = (pos == IJPos::e0) ? 3 : (pos == IJPos::e1) ? 4 : 5;
+        if (edge_owners[indx[e_pos]] != indx[6])
+          continue;
+      }
+
       int x = grid_x(i, j);
       int y = grid_y(i, j);
       int n[] = {x, y, freq - x - y};
@@ -376,12 +431,14 @@ void Geodesic::grid_to_points(vector<int> indx, vector<Vec3d> &gverts)
 void Geodesic::make_grid_idxs()
 {
   int test_val = 2 * freq / (m + n);
+  grid_sz = std::max(test_val - 1, 0);
+  grid_idxs.assign(grid_sz * grid_sz, noindex);
   int idx = 0;
   // i and j at twice the corner angle (which lies inside the axes)
-  for (int i = 0; i < test_val - 1; i++)
-    for (int j = 0; j < test_val - 1; j++)
+  for (int i = 0; i < grid_sz; i++)
+    for (int j = 0; j < grid_sz; j++)
       if (get_pos(i, j).is_face())
-        grid_idxs[int_pr(i, j)] = idx++;
+        grid_idxs[i * grid_sz + j] = idx++;
 }
 
 inline vector<int> make_tri(int v0, int v1, int v2)
@@ -394,7 +451,7 @@ inline vector<int> make_tri(int v0, int v1, int v2)
 }
 
 int orig_edge(IJPos p0_pos, int p0_idx, IJPos p1_pos, int p1_idx,
-              vector<int> &indx, vector<int> &e_col)
+              const vector<int> &indx, vector<int> &e_col)
 {
   const int e_to_indx[] = {0, 5, 3, 1, 4, 3, 2, 7};
   int e_no = 0;
@@ -428,7 +485,7 @@ int orig_edge(IJPos p0_pos, int p0_idx, IJPos p1_pos, int p1_idx,
 }
 
 void add_orig_edges(IJPos p0_pos, int p0_idx, IJPos p1_pos, int p1_idx,
-                    IJPos p2_pos, int p2_idx, vector<int> &indx,
+                    IJPos p2_pos, int p2_idx, const vector<int> &indx,
                     vector<vector<int>> &e_cols)
 {
   vector<int> e_col;
@@ -440,7 +497,7 @@ void add_orig_edges(IJPos p0_pos, int p0_idx, IJPos p1_pos, int p1_idx,
     e_cols.push_back(e_col);
 }
 
-inline bool Geodesic::tri_test(int i, int j, int di, int dj)
+inline bool Geodesic::tri_test(int i, int j, int di, int dj) const
 {
   IJPos p0 = get_pos(i, j);
   IJPos p1 = get_pos(i + 1, j + 1);
@@ -468,8 +525,9 @@ inline bool Geodesic::tri_test(int i, int j, int di, int dj)
     return dj;
 }
 
-void Geodesic::grid_to_tris(vector<int> indx, vector<vector<int>> &new_tris,
-                            vector<vector<int>> &orig_edges)
+void Geodesic::grid_to_tris(const vector<int> &indx,
+                            vector<vector<int>> &new_tris,
+                            vector<vector<int>> &orig_edges) const
 {
   int p0_idx, p1_idx, p2_idx, p3_idx;
 
@@ -36,6 +36,7 @@
 #include "utils.h"
 
 #include <algorithm>
+#include <cstdint>
 
 using std::map;
 using std::pair;
@@ -63,10 +64,44 @@ int Geometry::add_verts(const vector<Vec3d> &vrts)
   return verts().size() - 1;
 }
 
+// Edge lists shorter than this are searched directly
+static const unsigned int min_edge_index_sz = 64;
+
+static inline unsigned long long edge_key(int v_idx0, int v_idx1)
+{
+  return ((unsigned long long)(unsigned int)v_idx0 << 32) |
+         (unsigned int)v_idx1;
+}
+
+int Geometry::EdgeIndex::find(const vector<vector<int>> &edgs,
+                              const vector<int> &edge)
+{
+  if (edgs.size() < min_edge_index_sz || edge.size() != 2) {
+    auto ei = std::find(edgs.begin(), edgs.end(), edge);
+    return (ei != edgs.end()) ? ei - edgs.begin() : -1;
+  }
+
+  // the edge list may have been shortened through raw_edges()
+  if (idxs_cnt == 0 || idxs_cnt > edgs.size()) {
+    idxs.clear();
+    idxs_cnt = 0;
+  }
+  // index any edges added since the last search, keeping the first
+  // occurrence of a repeated edge
+  for (; idxs_cnt < edgs.size(); idxs_cnt++) {
+    const vector<int> &e = edgs[idxs_cnt];
+    if (e.size() == 2)
+      idxs.insert(std::make_pair(edge_key(e[0], e[1]), (int)idxs_cnt));
+  }
+
+  auto ei = idxs.find(edge_key(edge[0], edge[1]));
+  return (ei != idxs.end()) ? ei->second : -1;
+}
+
 int Geometry::add_edge_raw(const vector<int> &edge, Color col)
 {
   int idx = edges().size();
-  raw_edges().push_back(edge);
+  edge_elems.push_back(edge);
   if (col.is_set())
     colors(EDGES).set(idx, col);
   return idx;
@@ -81,17 +116,14 @@ int Geometry::add_edges_raw(const vector<vector<int>> &edgs)
 
 int Geometry::add_edge(std::vector<int> edge, Color col)
 {
-  int idx;
   if (edge[0] > edge[1])
     swap(edge[0], edge[1]);
-  auto ei = find(edges().begin(), edges().end(), edge);
-  if (ei != edges().end()) {
-    idx = ei - edges().begin();
+  int idx = edge_idx.find(edges(), edge);
+  if (idx >= 0)
     colors(EDGES).set(idx, col);
-  }
   else {
     idx = edges().size();
-    raw_edges().push_back(edge);
+    edge_elems.push_back(edge);
     if (col.is_set())
       colors(EDGES).set(idx, col);
   }
@@ -294,6 +326,38 @@ void Geometry::clear_all()
 
 void Geometry::get_impl_edges(vector<vector<int>> &edgs) const
 {
+  if (edgs.empty()) {
+    // Sort the face sides as packed vertex index pairs, which avoids
+    // allocating and comparing a vector for every face side
+    vector<uint64_t> keys;
+    bool valid = true;
+    for (const auto &face : faces()) {
+      for (unsigned int j = 0; j < face.size(); ++j) {
+        int v0 = face[j];
+        int v1 = face[(j + 1) % face.size()];
+        if (v0 < 0 || v1 < 0) {
+          valid = false;
+          break;
+        }
+        if (v0 > v1)
+          std::swap(v0, v1);
+        keys.push_back((uint64_t)v0 << 32 | (uint64_t)v1);
+      }
+      if (!valid)
+        break;
+    }
+    if (valid) {
+      sort(keys.begin(), keys.end());
+      keys.erase(unique(keys.begin(), keys.end()), keys.end());
+      edgs.resize(keys.size(), vector<int>(2));
+      for (unsigned int i = 0; i < keys.size(); ++i) {
+        edgs[i][0] = (int)(keys[i] >> 32);
+        edgs[i][1] = (int)(keys[i] & 0xffffffff);
+      }
+      return;
+    }
+  }
+
   // edgs hasn't been cleared
   for (unsigned int i = 0; i < faces().size(); ++i)
     for (unsigned int j = 0; j < faces(i).size(); ++j)
@@ -390,45 +454,13 @@ vector<int> make_edge(int v_idx1, int v_idx2)
 
 bool Geometry::is_oriented() const
 {
-  std::set<pair<int, int>> edgs;
-  pair<int, int> edge;
-  for (unsigned int f = 0; f < faces().size(); f++)
-    for (unsigned int i = 0; i < faces(f).size(); i++) {
-      edge = pair<int, int>(faces(f, i), faces_mod(f, i + 1));
-      if (edgs.find(edge) != edgs.end())
-        return false;
-      else
-        edgs.insert(edge);
-    }
-  return true;
+  return get_half_edges()->is_oriented();
 }
 
 std::map<std::vector<int>, std::vector<int>>
 Geometry::get_edge_face_pairs(bool oriented) const
 {
-  map<vector<int>, vector<int>> edge2facepr;
-  vector<int> vrts(2);
-  for (unsigned int i = 0; i < faces().size(); ++i) {
-    for (unsigned int j = 0; j < faces(i).size(); ++j) {
-      vrts[0] = faces(i, j);
-      vrts[1] = faces_mod(i, j + 1);
-      int face_pos = 0;
-      if (vrts[0] > vrts[1]) {
-        swap(vrts[0], vrts[1]);
-        face_pos = 1;
-      }
-      if (oriented) {
-        if (edge2facepr.find(vrts) == edge2facepr.end()) {
-          edge2facepr[vrts].resize(2);
-          edge2facepr[vrts][(face_pos + 1) % 2] = -1;
-        }
-        edge2facepr[vrts][face_pos] = i;
-      }
-      else
-        edge2facepr[vrts].push_back(i);
-    }
-  }
-  return edge2facepr;
+  return get_half_edges()->get_edge_face_pairs(oriented);
 }
 
 void Geometry::verts_merge(map<int, int> &vmap)
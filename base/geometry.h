@@ -30,12 +30,17 @@
 #define GEOMETRY_H
 
 #include "elemprops.h"
+#include "halfedges.h"
 #include "status.h"
 #include "trans3d.h"
 #include "vec_utils.h"
 
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace anti {
@@ -45,9 +50,87 @@ class GeometryInfo;
 /// Geometry Interface
 class Geometry {
 private:
+  /// Hash index of the edge list, used by \c add_edge() to find an edge
+  /** The index is built when first needed, extended as edges are added,
+   *  and discarded when the edge list is accessed for writing. It is not
+   *  copied with the geometry. */
+  class EdgeIndex {
+  private:
+    std::unordered_map<unsigned long long, int> idxs;
+    unsigned int idxs_cnt = 0; // number of edges that have been indexed
+
+  public:
+    EdgeIndex() = default;
+    EdgeIndex(const EdgeIndex &) {}
+    EdgeIndex &operator=(const EdgeIndex &)
+    {
+      invalidate();
+      return *this;
+    }
+
+    /// Discard the index
+    void invalidate() { idxs_cnt = 0; }
+
+    /// Find an edge
+    /**\param edgs the edge list.
+     * \param edge the edge to find.
+     * \return The edge with lowest index number, otherwise -1 */
+    int find(const std::vector<std::vector<int>> &edgs,
+             const std::vector<int> &edge);
+  };
+
+  /// Half-edge connectivity of the faces, used by \c get_half_edges()
+  /** The connectivity is built when first needed. When the face list has
+   *  been accessed for writing it is checked against the faces when next
+   *  requested, and only rebuilt if they have changed. It is shared with
+   *  the callers, so a connectivity that is replaced stays valid while a
+   *  caller holds it. The build is guarded, so the connectivity may be
+   *  requested from several threads at once. It is not copied with the
+   *  geometry. */
+  class HalfEdgesCache {
+  private:
+    std::shared_ptr<const HalfEdges> hes;
+    std::atomic<bool> faces_written{false};
+    std::mutex hes_mutex;
+
+  public:
+    HalfEdgesCache() = default;
+    HalfEdgesCache(const HalfEdgesCache &) {}
+    HalfEdgesCache &operator=(const HalfEdgesCache &)
+    {
+      invalidate();
+      return *this;
+    }
+
+    /// Note that the faces may have changed
+    /** Called when the faces are accessed for writing. */
+    void invalidate()
+    {
+      faces_written.store(true, std::memory_order_relaxed);
+    }
+
+    /// Get the connectivity
+    /**\param geom the geometry that holds the cache.
+     * \return The connectivity, built if not set or not current. */
+    std::shared_ptr<const HalfEdges> get(const Geometry &geom)
+    {
+      std::lock_guard<std::mutex> lock(hes_mutex);
+      if (faces_written.exchange(false) && hes && !hes->is_current(geom))
+        hes.reset();
+      if (!hes)
+        hes = std::make_shared<const HalfEdges>(geom);
+      return hes;
+    }
+  };
+
   std::vector<Vec3d> vert_elems;
+  // The faces are edited in place through raw_faces(), so they are kept as
+  // a list of faces. A flat copy of the faces is no quicker to read in the
+  // per-face loops, and costs about as much to make as one pass over them.
   std::vector<std::vector<int>> face_elems;
   std::vector<std::vector<int>> edge_elems;
+  EdgeIndex edge_idx;
+  mutable HalfEdgesCache half_edges;
 
   GeomElemProps<Color> cols;
 
@@ -100,7 +183,11 @@ public:
   virtual const std::vector<std::vector<int>> &edges() const;
 
   /// Read/Write access to the edges.
-  /**\return A reference to the edge data. */
+  /** The edge index used by \c add_edge() and \c add_edges() is
+   *  discarded, and rebuilt by the next of those calls. Edges appended
+   *  through the reference after that are indexed, but other changes made
+   *  through it are not seen, so call this again for each set of changes.
+   * \return A reference to the edge data. */
   virtual std::vector<std::vector<int>> &raw_edges();
 
   /// Read access to an edge.
@@ -127,7 +214,10 @@ public:
   virtual const std::vector<std::vector<int>> &faces() const;
 
   /// Read/Write access to the faces.
-  /**\return A reference to the face data. */
+  /** The connectivity held for \c get_half_edges() is checked against
+   *  the faces when next requested. Changes made through the reference
+   *  after that are not seen, so call this again for each set of changes.
+   * \return A reference to the face data. */
   virtual std::vector<std::vector<int>> &raw_faces();
 
   /// Read access to a face.
@@ -136,7 +226,16 @@ public:
   virtual const std::vector<int> &faces(int f_idx) const;
 
   /// Read/Write access to a face.
-  /**\param f_idx index number of the face.
+  /** The connectivity is checked as for \c raw_faces(), and the same
+   *  rule applies to the reference.
+   * \param f_idx index number of the face.
+   * \return A reference to the face data. */
+  virtual std::vector<int> &raw_faces(int f_idx);
+
+  /// Read/Write access to a face.
+  /** The same as \c raw_faces(int), which should be preferred when
+   *  changing a face. A face is read more cheaply from a const geometry.
+   * \param f_idx index number of the face.
    * \return A reference to the face data. */
   virtual std::vector<int> &faces(int f_idx);
 
@@ -593,6 +692,18 @@ public:
    * \return edge2facepr return map of edges to face pairs.*/
   std::map<std::vector<int>, std::vector<int>>
   get_edge_face_pairs(bool oriented = true) const;
+
+  /// Get the half-edge connectivity of the faces
+  /** The connectivity is built when first needed, and is rebuilt if the
+   *  faces have changed since they were last accessed for writing (see
+   *  \c raw_faces() for changes that are not seen.) The connectivity
+   *  stays valid while the pointer is held, but is not updated. May be
+   *  called from several threads at once.
+   * \return The half-edge connectivity. */
+  std::shared_ptr<const HalfEdges> get_half_edges() const
+  {
+    return half_edges.get(*this);
+  }
 };
 
 /// Make a face from vertex index numbers
@@ -762,6 +873,7 @@ inline Vec3d &Geometry::verts(int v_idx) { return vert_elems[v_idx]; }
 
 inline std::vector<std::vector<int>> &Geometry::raw_edges()
 {
+  edge_idx.invalidate();
   return edge_elems;
 }
 
@@ -782,6 +894,7 @@ inline int Geometry::edges(int e_idx, int v_no) const
 
 inline std::vector<std::vector<int>> &Geometry::raw_faces()
 {
+  half_edges.invalidate();
   return face_elems;
 }
 
@@ -795,11 +908,14 @@ inline const std::vector<int> &Geometry::faces(int f_idx) const
   return face_elems[f_idx];
 }
 
-inline std::vector<int> &Geometry::faces(int f_idx)
+inline std::vector<int> &Geometry::raw_faces(int f_idx)
 {
+  half_edges.invalidate();
   return face_elems[f_idx];
 }
 
+inline std::vector<int> &Geometry::faces(int f_idx) { return raw_faces(f_idx); }
+
 inline int Geometry::faces(int f_idx, int v_no) const
 {
   return face_elems[f_idx][v_no];
@@ -30,9 +30,11 @@
 #include "geometryutils.h"
 #include "mathutils.h"
 #include "private_misc.h"
+#include "threadpool.h"
 
 #include <algorithm>
 #include <cstring>
+#include <functional>
 #include <limits>
 #include <map>
 #include <set>
@@ -104,11 +106,46 @@ void ElementLimits::init()
 
 bool ElementLimits::is_set() const { return idx[0] != -1; }
 
+//---------------------------------------------------------------------
+// Element values
+
+// Call part_func(start, end) on consecutive ranges that together cover
+// num_items items, with the ranges divided between num_threads threads
+static void run_parts(int num_threads, int num_items,
+                      const std::function<void(int, int)> &part_func)
+{
+  if (num_threads == 1 || num_items < 2) {
+    part_func(0, num_items);
+    return;
+  }
+  ThreadPool pool(num_threads);
+  const int num_parts = pool.get_num_threads();
+  pool.run(num_parts, [&](int part) {
+    part_func(part_start(num_items, num_parts, part),
+              part_start(num_items, num_parts, part + 1));
+  });
+}
+
+// Count values by size, adding them in element order so that values
+// are grouped exactly as if they had been added while being calculated
+static void find_ranges(map<double, double_range_cnt, AngleLess> &ranges,
+                        const vector<double> &vals)
+{
+  ranges.clear();
+  for (double val : vals) {
+    auto ri = ranges.find(val);
+    if (ri == ranges.end())
+      ranges[val] = double_range_cnt().update(val);
+    else
+      ri->second.update(val);
+  }
+}
+
 //---------------------------------------------------------------------
 // GeometryInfo
 
 GeometryInfo::GeometryInfo(const Geometry &geo, Vec3d center)
-    : cent(center), geom(geo)
+    : cent(center), num_threads(1), geom(geo)
 {
   reset();
 }
@@ -126,12 +163,20 @@ void GeometryInfo::reset()
   face_angles.clear();
   vert_dihed.clear();
   dihedral_angles.clear();
+  edge_dihedrals.clear();
   edge_index_numbers.clear();
   e_lengths.clear();
+  ie_lengths.clear();
+  edge_lengths.clear();
+  iedge_lengths.clear();
   sol_angles.clear();
   vertex_angles.clear();
+  vf_plane_angles.clear();
+  f_plane_angles.clear();
+  f_plane_angle_starts.clear();
   f_areas.clear();
   f_perimeters.clear();
+  f_max_nonplanars.clear();
   vert_impl_edges.clear();
   vert_faces.clear();
   vert_cons.clear();
@@ -152,6 +197,16 @@ void GeometryInfo::set_center(Vec3d center)
   f_dists.init();
 }
 
+Status GeometryInfo::set_num_threads(int num)
+{
+  if (num < 0)
+    return Status::error("number of threads cannot be negative");
+  num_threads = num;
+  return Status::ok();
+}
+
+int GeometryInfo::get_num_threads() const { return num_threads; }
+
 const Geometry &GeometryInfo::get_geom() const { return geom; }
 
 Vec3d GeometryInfo::get_center() const { return cent; }
@@ -234,26 +289,26 @@ double GeometryInfo::isoperimetric_quotient()
 
 ElementLimits GeometryInfo::edge_length_lims()
 {
-  get_edge_lengths_by_size();
+  get_edge_lengths();
   return edge_len;
 }
 
 ElementLimits GeometryInfo::iedge_length_lims()
 {
-  get_iedge_lengths_by_size();
+  get_iedge_lengths();
   return iedge_len;
 }
 
 ElementLimits GeometryInfo::dihed_angle_lims()
 {
-  if (dihedral_angles.size() == 0)
+  if (edge_dihedrals.size() == 0)
     find_dihedral_angles();
   return dih_angles;
 }
 
 ElementLimits GeometryInfo::solid_angle_lims()
 {
-  if (sol_angles.size() == 0)
+  if (vertex_angles.size() == 0)
     find_solid_angles();
   return so_angles;
 }
@@ -288,14 +343,14 @@ ElementLimits &GeometryInfo::face_dist_lims()
 
 ElementLimits GeometryInfo::angle_lims()
 {
-  if (!plane_angles.size())
+  if (!f_plane_angle_starts.size())
     find_face_angles();
   return ang;
 }
 
 int GeometryInfo::num_angles()
 {
-  if (!plane_angles.size())
+  if (!f_plane_angle_starts.size())
     find_face_angles();
   return num_angs;
 }
@@ -359,14 +414,20 @@ const map<double, double_range_cnt, AngleLess> &
 GeometryInfo::get_solid_angles_by_size()
 {
   if (!sol_angles.size())
-    find_solid_angles();
+    find_ranges(sol_angles, get_vert_solid_angles());
   return sol_angles;
 }
 
 const map<pair<int, int>, double> &GeometryInfo::get_plane_angles()
 {
-  if (!plane_angles.size())
+  if (!f_plane_angle_starts.size())
     find_face_angles();
+  if (!vf_plane_angles.size()) {
+    for (unsigned int i = 0; i < geom.faces().size(); i++)
+      for (unsigned int j = 0; j < geom.faces(i).size(); j++)
+        vf_plane_angles[pair<int, int>(geom.faces(i, j), i)] =
+            f_plane_angles[f_plane_angle_starts[i] + j];
+  }
   return vf_plane_angles;
 }
 
@@ -396,7 +457,7 @@ const map<vector<int>, vector<int>> &GeometryInfo::get_edge_face_pairs()
 
 const vector<double> &GeometryInfo::get_edge_dihedrals()
 {
-  if (!dihedral_angles.size())
+  if (!edge_dihedrals.size())
     find_dihedral_angles();
   return edge_dihedrals;
 }
@@ -412,15 +473,22 @@ const map<double, double_range_cnt, AngleLess> &
 GeometryInfo::get_dihedral_angles_by_size()
 {
   if (!dihedral_angles.size())
-    find_dihedral_angles();
+    find_ranges(dihedral_angles, get_edge_dihedrals());
   return dihedral_angles;
 }
 
+const vector<double> &GeometryInfo::get_edge_lengths()
+{
+  if (!edge_lengths.size())
+    find_e_lengths(edge_lengths, geom.edges(), edge_len);
+  return edge_lengths;
+}
+
 const map<double, double_range_cnt, AngleLess> &
 GeometryInfo::get_edge_lengths_by_size()
 {
   if (!e_lengths.size())
-    find_e_lengths(e_lengths, geom.edges(), edge_len);
+    find_ranges(e_lengths, get_edge_lengths());
   return e_lengths;
 }
 
@@ -432,11 +500,18 @@ const vector<vector<int>> &GeometryInfo::get_impl_edges()
   return impl_edges;
 }
 
+const vector<double> &GeometryInfo::get_iedge_lengths()
+{
+  if (!iedge_lengths.size())
+    find_e_lengths(iedge_lengths, get_impl_edges(), iedge_len);
+  return iedge_lengths;
+}
+
 const map<double, double_range_cnt, AngleLess> &
 GeometryInfo::get_iedge_lengths_by_size()
 {
   if (!ie_lengths.size())
-    find_e_lengths(ie_lengths, get_impl_edges(), iedge_len);
+    find_ranges(ie_lengths, get_iedge_lengths());
   return ie_lengths;
 }
 
@@ -444,8 +519,29 @@ GeometryInfo::get_iedge_lengths_by_size()
 const map<vector<double>, int, AngleVectLess> &
 GeometryInfo::get_plane_angles_by_size()
 {
-  if (!face_angles.size())
+  if (!f_plane_angle_starts.size())
     find_face_angles();
+  if (!face_angles.size()) {
+    for (unsigned int i = 0; i < geom.faces().size(); i++) {
+      unsigned int fsz = geom.faces(i).size();
+      auto f_first = f_plane_angles.begin() + f_plane_angle_starts[i];
+      vector<double> f1(f_first, f_first + fsz), f2(fsz), f_min(f1);
+      for (unsigned int offset = 0; offset < fsz; offset++) {
+        for (unsigned int k = 0; k < fsz; k++)
+          f2[(k + offset) % fsz] = f1[k];
+        if (cmp_face_angles(f2, f_min) < 0)
+          f_min = f2;
+        reverse(f2.begin(), f2.end());
+        if (cmp_face_angles(f2, f_min) < 0)
+          f_min = f2;
+      }
+      auto fi = face_angles.find(f_min);
+      if (fi == face_angles.end())
+        face_angles[f_min] = 1;
+      else
+        fi->second += 1;
+    }
+  }
   return face_angles;
 }
 
@@ -523,7 +619,7 @@ Trans3d GeometryInfo::get_symmetry_alignment_to_std()
 bool GeometryInfo::is_oriented()
 {
   if (oriented < 0)
-    oriented = geom.is_oriented();
+    oriented = geom.get_half_edges()->is_oriented();
   return oriented;
 }
 
@@ -539,37 +635,28 @@ bool GeometryInfo::is_orientable()
 
 void GeometryInfo::find_edge_face_pairs()
 {
-  if (is_oriented())
-    efpairs = geom.get_edge_face_pairs(true);
-  else
-    efpairs = geom.get_edge_face_pairs(false);
+  efpairs = geom.get_half_edges()->get_edge_face_pairs(is_oriented());
 }
 
 void GeometryInfo::find_connectivity()
 {
-  // get a copy of edge face pairs with all faces around an edge
-  map<vector<int>, vector<int>> tmp_efpairs;
-  if (is_oriented())
-    tmp_efpairs = geom.get_edge_face_pairs(false);
-  else if (efpairs.size() == 0)
-    find_edge_face_pairs();
-
-  const map<vector<int>, vector<int>> &pairs =
-      is_oriented() ? tmp_efpairs : efpairs;
+  // the number of faces around an edge
+  const auto hes_ptr = geom.get_half_edges();
+  const HalfEdges &hes = *hes_ptr;
 
   known_connectivity = true;
   even_connectivity = true;
   polyhedron = true;
   closed = true;
-  map<vector<int>, vector<int>>::const_iterator ei;
-  for (ei = pairs.begin(); ei != pairs.end(); ++ei) {
-    if (ei->second.size() == 1) // One faces at an edge
+  for (int e_idx = 0; e_idx < hes.num_edges(); e_idx++) {
+    const int e_sz = hes.edge_size(e_idx);
+    if (e_sz == 1) // One faces at an edge
       closed = false;
-    if (ei->second.size() != 2) // Edge not met be exactly 2 faces
+    if (e_sz != 2) // Edge not met be exactly 2 faces
       polyhedron = false;
-    if (ei->second.size() % 2) // Odd number of faces at an edge
+    if (e_sz % 2) // Odd number of faces at an edge
       even_connectivity = false;
-    if (ei->second.size() > 2) // More than two faces at an edge
+    if (e_sz > 2) // More than two faces at an edge
       known_connectivity = false;
   }
 
@@ -603,11 +690,20 @@ void GeometryInfo::find_f_areas()
 {
   int fsz = geom.faces().size();
   f_areas.resize(fsz);
+  vector<double> f_vols(fsz);
+  vector<Vec3d> f_vol_cents(fsz);
+  run_parts(num_threads, fsz, [&](int start, int end) {
+    for (int i = start; i < end; i++) {
+      f_areas[i] = geom.face_norm(i, true).len();
+      f_vols[i] = face_vol(geom, i, &f_vol_cents[i]);
+    }
+  });
+
+  // combine the values in face order
   area.init();
   vol = 0;
   vol_cent = Vec3d(0, 0, 0);
   for (int i = 0; i < fsz; i++) {
-    f_areas[i] = geom.face_norm(i, true).len();
     if (f_areas[i] < area.min) {
       area.min = f_areas[i];
       area.idx[ElementLimits::IDX_MIN] = i;
@@ -617,10 +713,8 @@ void GeometryInfo::find_f_areas()
       area.idx[ElementLimits::IDX_MAX] = i;
     }
     area.sum += f_areas[i];
-    Vec3d f_vol_cent;
-    double f_vol = face_vol(geom, i, &f_vol_cent);
-    vol += f_vol;
-    vol_cent += f_vol_cent * f_vol;
+    vol += f_vols[i];
+    vol_cent += f_vol_cents[i] * f_vols[i];
   }
   if (!double_eq(vol, 0))
     vol_cent /= vol;
@@ -631,55 +725,44 @@ void GeometryInfo::find_f_areas()
 void GeometryInfo::find_f_perimeters()
 {
   f_perimeters.resize(num_faces());
-  for (unsigned int i = 0; i < geom.faces().size(); i++) {
-    double perim = 0.0;
-    for (unsigned int j = 0; j < geom.faces(i).size(); j++)
-      perim += geom.edge_vec(geom.faces(i, j), geom.faces_mod(i, j + 1)).len();
-    f_perimeters[i] = perim;
-  }
+  run_parts(num_threads, num_faces(), [&](int start, int end) {
+    for (int i = start; i < end; i++) {
+      double perim = 0.0;
+      for (unsigned int j = 0; j < geom.faces(i).size(); j++)
+        perim +=
+            geom.edge_vec(geom.faces(i, j), geom.faces_mod(i, j + 1)).len();
+      f_perimeters[i] = perim;
+    }
+  });
 }
 
 void GeometryInfo::find_face_angles()
 {
-  ang.init();
-  num_angs = 0;
-  map<vector<double>, int, AngleVectLess>::iterator fi;
-  map<double, double_range_cnt, AngleLess>::iterator ai;
-
-  for (unsigned int i = 0; i < geom.faces().size(); i++) {
-    unsigned int fsz = geom.faces(i).size();
-    vector<double> f1(fsz), f2(fsz), f_min(fsz);
-    geom.face_angles_lengths(i, &f1);
-    f_min = f1;
-    for (unsigned int offset = 0; offset < fsz; offset++) {
-      pair<int, int> vf_pr(geom.faces(i, offset), i);
-      const double f_ang = f1[offset];
-      vf_plane_angles[vf_pr] = f_ang;
-      ai = plane_angles.find(f_ang);
-      if (ai == plane_angles.end())
-        plane_angles[f_ang] = double_range_cnt().update(f_ang);
-      else
-        ai->second.update(f_ang);
-      if (ang.max < f_ang)
-        ang.max = f_ang;
-      if (ang.min > f_ang)
-        ang.min = f_ang;
-      ang.sum += f_ang;
-      num_angs++;
-
-      for (unsigned int k = 0; k < fsz; k++)
-        f2[(k + offset) % fsz] = f1[k];
-      if (cmp_face_angles(f2, f_min) < 0)
-        f_min = f2;
-      reverse(f2.begin(), f2.end());
-      if (cmp_face_angles(f2, f_min) < 0)
-        f_min = f2;
+  const int fsz = geom.faces().size();
+  f_plane_angle_starts.resize(fsz + 1);
+  f_plane_angle_starts[0] = 0;
+  for (int i = 0; i < fsz; i++)
+    f_plane_angle_starts[i + 1] =
+        f_plane_angle_starts[i] + geom.faces(i).size();
+  f_plane_angles.resize(f_plane_angle_starts.back());
+
+  run_parts(num_threads, fsz, [&](int start, int end) {
+    vector<double> f_angs;
+    for (int i = start; i < end; i++) {
+      geom.face_angles_lengths(i, &f_angs);
+      std::copy(f_angs.begin(), f_angs.end(),
+                f_plane_angles.begin() + f_plane_angle_starts[i]);
     }
-    fi = face_angles.find(f_min);
-    if (fi == face_angles.end())
-      face_angles[f_min] = 1;
-    else
-      fi->second += 1;
+  });
+
+  ang.init();
+  num_angs = f_plane_angles.size();
+  for (double f_ang : f_plane_angles) {
+    if (ang.max < f_ang)
+      ang.max = f_ang;
+    if (ang.min > f_ang)
+      ang.min = f_ang;
+    ang.sum += f_ang;
   }
 }
 
@@ -687,65 +770,63 @@ void GeometryInfo::find_dihedral_angles()
 {
   if (efpairs.size() == 0)
     find_edge_face_pairs();
-  edge_dihedrals.resize(efpairs.size());
-
-  dih_angles.init();
-  map<vector<int>, vector<int>>::iterator ei;
-  map<double, double_range_cnt, AngleLess>::iterator di;
-  double cos_a = 1, sign = 1;
-  int e_idx = -1;
-  for (ei = efpairs.begin(); ei != efpairs.end(); ++ei) {
-    e_idx++;
-    if (ei->second.size() == 2 && ei->second[0] >= 0 &&
-        ei->second[1] >= 0) { // pair of faces
-      Vec3d n0;
-      Vec3d n1;
-      if (is_oriented()) {
-        n0 = geom.face_norm(ei->second[0]).unit();
-        n1 = geom.face_norm(ei->second[1]).unit();
-        Vec3d e_dir = geom.verts(ei->first[1]) - geom.verts(ei->first[0]);
-        sign = vdot(e_dir, vcross(n0, n1));
-      }
-      else {
-        vector<int> f0 = geom.faces(ei->second[0]);
-        vector<int> f1 = geom.faces(ei->second[1]);
-        orient_face(f0, ei->first[0], ei->first[1]);
-        orient_face(f1, ei->first[1], ei->first[0]);
-        n0 = face_norm(geom.verts(), f0).unit();
-        n1 = face_norm(geom.verts(), f1).unit();
-        sign = 1;
+  vector<map<vector<int>, vector<int>>::const_iterator> e_its;
+  e_its.reserve(efpairs.size());
+  for (auto ei = efpairs.cbegin(); ei != efpairs.cend(); ++ei)
+    e_its.push_back(ei);
+  edge_dihedrals.resize(e_its.size());
+
+  const bool oriented = is_oriented();
+  run_parts(num_threads, e_its.size(), [&](int start, int end) {
+    for (int e_idx = start; e_idx < end; e_idx++) {
+      const auto ei = e_its[e_idx];
+      double cos_a = 1, sign = 1;
+      if (ei->second.size() == 2 && ei->second[0] >= 0 &&
+          ei->second[1] >= 0) { // pair of faces
+        Vec3d n0;
+        Vec3d n1;
+        if (oriented) {
+          n0 = geom.face_norm(ei->second[0]).unit();
+          n1 = geom.face_norm(ei->second[1]).unit();
+          Vec3d e_dir = geom.verts(ei->first[1]) - geom.verts(ei->first[0]);
+          sign = vdot(e_dir, vcross(n0, n1));
+        }
+        else {
+          vector<int> f0 = geom.faces(ei->second[0]);
+          vector<int> f1 = geom.faces(ei->second[1]);
+          orient_face(f0, ei->first[0], ei->first[1]);
+          orient_face(f1, ei->first[1], ei->first[0]);
+          n0 = face_norm(geom.verts(), f0).unit();
+          n1 = face_norm(geom.verts(), f1).unit();
+        }
+        cos_a = -vdot(n0, n1);
       }
-      cos_a = -vdot(n0, n1);
+      double ang = acos(safe_for_trig(cos_a)); // cos_a is 1 for one face
+      if (sign < 0)                            // in oriented polyhedron
+        ang = 2 * M_PI - ang;
+      edge_dihedrals[e_idx] = ang;
     }
-    else
-      cos_a = 1; // one face on an edge
-    double ang = acos(safe_for_trig(cos_a));
-    if (sign < 0) // in oriented polyhedron
-      ang = 2 * M_PI - ang;
-
-    edge_dihedrals[e_idx] = ang;
+  });
 
+  dih_angles.init();
+  for (unsigned int e_idx = 0; e_idx < e_its.size(); e_idx++) {
+    const vector<int> &edge = e_its[e_idx]->first;
+    const double ang = edge_dihedrals[e_idx];
     if (ang > dih_angles.max) {
       dih_angles.max = ang;
-      dih_angles.idx[ElementLimits::IDX_MAX] = ei->first[0];
-      dih_angles.idx[ElementLimits::IDX_MAX2] = ei->first[1];
+      dih_angles.idx[ElementLimits::IDX_MAX] = edge[0];
+      dih_angles.idx[ElementLimits::IDX_MAX2] = edge[1];
     }
     if (ang < dih_angles.min) {
       dih_angles.min = ang;
-      dih_angles.idx[ElementLimits::IDX_MIN] = ei->first[0];
-      dih_angles.idx[ElementLimits::IDX_MIN2] = ei->first[1];
+      dih_angles.idx[ElementLimits::IDX_MIN] = edge[0];
+      dih_angles.idx[ElementLimits::IDX_MIN2] = edge[1];
     }
     if (fabs(ang - M_PI) < fabs(dih_angles.zero)) {
       dih_angles.zero = ang;
-      dih_angles.idx[ElementLimits::IDX_ZERO] = ei->first[0];
-      dih_angles.idx[ElementLimits::IDX_ZERO2] = ei->first[1];
+      dih_angles.idx[ElementLimits::IDX_ZERO] = edge[0];
+      dih_angles.idx[ElementLimits::IDX_ZERO2] = edge[1];
     }
-
-    di = dihedral_angles.find(ang);
-    if (di == dihedral_angles.end())
-      dihedral_angles[ang] = double_range_cnt().update(ang);
-    else
-      di->second.update(ang);
   }
 }
 
@@ -855,17 +936,16 @@ void GeometryInfo::find_vert_elems(const vector<vector<int>> &elems,
 void GeometryInfo::find_face_cons()
 {
   face_cons.resize(num_faces(), vector<vector<int>>());
-  auto e2fs = geom.get_edge_face_pairs(false);
-  for (unsigned int f_idx = 0; f_idx < geom.faces().size(); f_idx++) {
-    for (unsigned int v = 0; v < geom.faces(f_idx).size(); v++) {
-      face_cons[f_idx].push_back(vector<int>());
-      auto ei = e2fs.find(
-          make_edge(geom.faces(f_idx, v), geom.faces_mod(f_idx, v + 1)));
-      if (ei != e2fs.end()) { // test, but shouldn't fail
-        for (int i : ei->second) {
-          if (i != (int)f_idx)
-            face_cons[f_idx][v].push_back(i);
-        }
+  const auto hes_ptr = geom.get_half_edges();
+  const HalfEdges &hes = *hes_ptr;
+  for (int f_idx = 0; f_idx < (int)geom.faces().size(); f_idx++) {
+    face_cons[f_idx].resize(hes.face_size(f_idx));
+    for (int v = 0; v < hes.face_size(f_idx); v++) {
+      const int e_idx = hes.edge(hes.face_start(f_idx) + v);
+      for (int n = 0; n < hes.edge_size(e_idx); n++) {
+        const int i = hes.face(hes.edge_half_edge(e_idx, n));
+        if (i != f_idx)
+          face_cons[f_idx][v].push_back(i);
       }
     }
   }
@@ -1032,23 +1112,27 @@ void GeometryInfo::find_solid_angles()
     find_vert_cons_orig();
 
   vertex_angles = vector<double>(num_verts(), 0);
+  run_parts(num_threads, vert_cons_orig.size(), [&](int start, int end) {
+    vector<Vec3d> dirs;
+    for (int i = start; i < end; i++) {
+      const int cons_sz = vert_cons_orig[i].size();
+      dirs.resize(cons_sz);
+      for (int j = 0; j < cons_sz; j++)
+        dirs[j] = geom.verts(i) - geom.verts(vert_cons_orig[i][j]);
+
+      for (int j = 1; j < cons_sz - 1; j++)
+        vertex_angles[i] += sph_tri_area(dirs[0], dirs[j], dirs[j + 1]);
+
+      // if(!is_oriented()) {
+      //   fmod(vertex_angles[i], 4*M_PI);
+      //   if(vertex_angles[i]>2*M_PI)
+      //      vertex_angles[i] = 4*M_PI - vertex_angles[i];
+      // }
+    }
+  });
 
   so_angles.init();
-  map<double, double_range_cnt, AngleLess>::iterator si;
   for (unsigned int i = 0; i < vert_cons_orig.size(); i++) {
-    vector<Vec3d> dirs(vert_cons_orig[i].size());
-    for (unsigned int j = 0; j < vert_cons_orig[i].size(); j++)
-      dirs[j] = geom.verts(i) - geom.verts(vert_cons_orig[i][j]);
-
-    for (unsigned int j = 1; j < vert_cons_orig[i].size() - 1; j++)
-      vertex_angles[i] += sph_tri_area(dirs[0], dirs[j], dirs[j + 1]);
-
-    // if(!is_oriented()) {
-    //   fmod(vertex_angles[i], 4*M_PI);
-    //   if(vertex_angles[i]>2*M_PI)
-    //      vertex_angles[i] = 4*M_PI - vertex_angles[i];
-    // }
-
     if (vertex_angles[i] > so_angles.max) {
       so_angles.max = vertex_angles[i];
       so_angles.idx[ElementLimits::IDX_MAX] = i;
@@ -1061,13 +1145,6 @@ void GeometryInfo::find_solid_angles()
       so_angles.zero = vertex_angles[i];
       so_angles.idx[ElementLimits::IDX_ZERO] = i;
     }
-
-    double s_ang = vertex_angles[i];
-    si = sol_angles.find(s_ang);
-    if (si == sol_angles.end())
-      sol_angles[s_ang] = double_range_cnt().update(s_ang);
-    else
-      si->second.update(s_ang);
   }
 }
 
@@ -1078,14 +1155,20 @@ void GeometryInfo::find_edge_index_numbers()
     edge_index_numbers[geom.edges(i)] = i;
 }
 
-void GeometryInfo::find_e_lengths(
-    map<double, double_range_cnt, AngleLess> &e_lens,
-    const vector<vector<int>> &edges, ElementLimits &lens)
+void GeometryInfo::find_e_lengths(vector<double> &e_lens,
+                                  const vector<vector<int>> &edges,
+                                  ElementLimits &lens)
 {
+  e_lens.resize(edges.size());
+  run_parts(num_threads, edges.size(), [&](int start, int end) {
+    for (int i = start; i < end; i++)
+      e_lens[i] = geom.edge_len(edges[i]);
+  });
+
   lens.init();
-  map<double, double_range_cnt, AngleLess>::iterator ei;
-  for (const auto &edge : edges) {
-    double dist = geom.edge_len(edge);
+  for (unsigned int i = 0; i < edges.size(); i++) {
+    const vector<int> &edge = edges[i];
+    const double dist = e_lens[i];
     if (dist > lens.max) {
       lens.max = dist;
       lens.idx[ElementLimits::IDX_MAX] = edge[0];
@@ -1097,11 +1180,6 @@ void GeometryInfo::find_e_lengths(
       lens.idx[ElementLimits::IDX_MIN2] = edge[1];
     }
     lens.sum += dist;
-    ei = e_lens.find(dist);
-    if (ei == e_lens.end())
-      e_lens[dist] = double_range_cnt().update(dist);
-    else
-      ei->second.update(dist);
   }
 }
 
@@ -1161,24 +1239,29 @@ void GeometryInfo::find_edge_parts()
 void GeometryInfo::find_f_max_nonplanars()
 {
   f_max_nonplanars.resize(geom.faces().size());
-  for (unsigned int f = 0; f < geom.faces().size(); f++) {
-    if (geom.faces(f).size() == 3) {
-      f_max_nonplanars[f] = 0;
-      continue;
-    }
-    Vec3d norm = geom.face_norm(f).unit();
-    Vec3d f_cent = geom.face_cent(f);
-    double max = 0;
-    for (unsigned int v = 0; v < geom.faces(f).size(); v++) {
-      double dist = fabs(vdot(norm, f_cent - geom.verts(geom.faces(f, v))));
-      if (dist > max)
-        max = dist;
+  run_parts(num_threads, num_faces(), [&](int start, int end) {
+    for (int f = start; f < end; f++) {
+      if (geom.faces(f).size() == 3) {
+        f_max_nonplanars[f] = 0;
+        continue;
+      }
+      Vec3d norm = geom.face_norm(f).unit();
+      Vec3d f_cent = geom.face_cent(f);
+      double max = 0;
+      for (unsigned int v = 0; v < geom.faces(f).size(); v++) {
+        double dist = fabs(vdot(norm, f_cent - geom.verts(geom.faces(f, v))));
+        if (dist > max)
+          max = dist;
+      }
+      f_max_nonplanars[f] = max;
     }
-    f_max_nonplanars[f] = max;
-  }
+  });
 }
 
-void GeometryInfo::find_symmetry() { sym.init(geom); }
+void GeometryInfo::find_symmetry()
+{
+  sym.init(geom, nullptr, num_threads);
+}
 
 int GeometryInfo::genus()
 {
@@ -31,6 +31,7 @@
 
 #include "geometry.h"
 #include "geometryutils.h"
+#include "status.h"
 
 namespace anti {
 
@@ -112,7 +113,11 @@ struct double_range_cnt {
  *  (some calculations find several assoociated properties).
  *  Properties are returned by reference, and may be accessed directly
  *  using the calling function without them being recalculated each
- *  time they are accessed.*/
+ *  time they are accessed. Numeric values are held in arrays indexed by
+ *  element, and the counts of values by size are only found from these
+ *  arrays when they are requested. The values for the elements may be
+ *  calculated on several threads, with identical results for any number
+ *  of threads.*/
 class GeometryInfo {
 private:
   Vec3d cent;
@@ -125,6 +130,7 @@ private:
   bool even_connectivity;
   int number_parts;
   int genus_val;
+  int num_threads;
   ElementLimits iedge_len;
   ElementLimits edge_len;
   ElementLimits so_angles;
@@ -148,11 +154,14 @@ private:
   std::map<double, double_range_cnt, AngleLess> dihedral_angles;
   std::map<double, double_range_cnt, AngleLess> e_lengths;
   std::map<double, double_range_cnt, AngleLess> ie_lengths;
-  std::map<double, double_range_cnt, AngleLess> plane_angles;
   std::map<double, double_range_cnt, AngleLess> sol_angles;
   std::vector<double> vertex_angles;
   std::map<std::pair<int, int>, double> vf_plane_angles;
+  std::vector<double> f_plane_angles;    // angles of all faces, in face order
+  std::vector<int> f_plane_angle_starts; // start of each face's angles
   std::vector<double> edge_dihedrals;
+  std::vector<double> edge_lengths;
+  std::vector<double> iedge_lengths;
   std::vector<double> f_areas;
   std::vector<double> f_perimeters;
   std::vector<double> f_max_nonplanars;
@@ -185,7 +194,7 @@ private:
   void find_vert_norms(bool local_orient = false);
   void find_free_verts();
   void find_solid_angles();
-  void find_e_lengths(std::map<double, double_range_cnt, AngleLess> &e_lens,
+  void find_e_lengths(std::vector<double> &e_lens,
                       const std::vector<std::vector<int>> &edges,
                       ElementLimits &lens);
   void find_f_areas();
@@ -226,6 +235,19 @@ public:
    * \param center the centre*/
   void set_center(Vec3d center);
 
+  /// Set the number of threads used to calculate element values
+  /** Also used to find the symmetry.
+   * \param num the number of threads, or \c 0 for the number of
+   *  processors.
+   * \return status, which evaluates to \c true if the number is valid,
+   *  otherwise \c false.*/
+  Status set_num_threads(int num);
+
+  /// Get the number of threads used to calculate element values
+  /**\return The number of threads, or \c 0 for the number of
+   *  processors.*/
+  int get_num_threads() const;
+
   // elements
   // ----------------------------------------------------------------
 
@@ -483,6 +505,10 @@ public:
   const std::map<double, double_range_cnt, AngleLess> &
   get_dihedral_angles_by_size();
 
+  /// Get the length of each explicit edge
+  /**\return The edge lengths.*/
+  const std::vector<double> &get_edge_lengths();
+
   /// Get explicit edge lengths by size
   /**\return The lengths of edges, and the number of edges having
    * each length.*/
@@ -494,7 +520,12 @@ public:
    * \return The implicit edges.*/
   const std::vector<std::vector<int>> &get_impl_edges();
 
-  /// Get explicit edge lengths by size
+  /// Get the length of each implicit edge
+  /**\return The implicit edge lengths, in the order of
+   *  \c get_impl_edges().*/
+  const std::vector<double> &get_iedge_lengths();
+
+  /// Get implicit edge lengths by size
   /**\return The lengths of edges, and the number of edges having
    * each length.*/
   const std::map<double, double_range_cnt, AngleLess> &
@@ -32,6 +32,7 @@
 #include "mathutils.h"
 #include "private_geodesic.h"
 #include "private_misc.h"
+#include "vertindex.h"
 
 #include <vector>
 
@@ -39,21 +40,24 @@ using std::vector;
 
 namespace anti {
 
-bool make_geodesic_planar(Geometry &geom, const Geometry &base, int m, int n)
+bool make_geodesic_planar(Geometry &geom, const Geometry &base, int m, int n,
+                          int num_threads)
 {
   if (m < 0 || n < 0 || (m == 0 && n == 0))
     return false; // invalid pattern
   Geodesic geod(base, m, n, 'p');
+  geod.set_num_threads(num_threads);
   geod.make_geo(geom);
   return true; // valid pattern
 }
 
 bool make_geodesic_sphere(Geometry &geom, const Geometry &base, int m, int n,
-                          Vec3d cent)
+                          Vec3d cent, int num_threads)
 {
   if (m < 0 || n < 0 || (m == 0 && n == 0))
     return false; // invalid pattern
   Geodesic geod(base, m, n, 's', cent);
+  geod.set_num_threads(num_threads);
   geod.make_geo(geom);
   return true; // valid pattern
 }
@@ -235,6 +239,18 @@ int find_edge_by_coords(const Geometry &geom, const Vec3d &v0, const Vec3d &v1,
   return (find_edge_in_edge_list(geom.edges(), make_edge(v0_idx, v1_idx)));
 }
 
+int find_edge_by_coords(const Geometry &geom, const VertIndex &vert_idx,
+                        const Vec3d &v0, const Vec3d &v1)
+{
+  int v0_idx = vert_idx.find(v0);
+  if (v0_idx == -1)
+    return -1;
+  int v1_idx = vert_idx.find(v1);
+  if (v1_idx == -1)
+    return -1;
+  return (find_edge_in_edge_list(geom.edges(), make_edge(v0_idx, v1_idx)));
+}
+
 vector<vector<int>> find_unmatched_edges(const Geometry &geom)
 {
   const vector<vector<int>> &faces = geom.faces();
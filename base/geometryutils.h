@@ -33,6 +33,7 @@
 #include "iteration.h"
 #include "normal.h"
 #include "symmetry.h"
+#include "vertindex.h"
 
 namespace anti {
 class GeometryInfo;
@@ -122,9 +123,11 @@ Status make_translation_surface(Geometry &geom, const Geometry &star0,
  * \param base the base polyhedron
  * \param m the first pattern specifier.
  * \param n the second pattern specifier.
+ * \param num_threads the number of threads to fill the base faces, or
+ *  \c 0 for the number of processors.
  * \return \c true if the pattern was valid, otherwise \c false. */
 bool make_geodesic_planar(Geometry &geom, const Geometry &base, int m,
-                          int n = 0);
+                          int n = 0, int num_threads = 1);
 
 /// Set spherical geodesic division.
 /** A Class I pattern is made with m=0,n=1. A Class II pattern
@@ -134,9 +137,12 @@ bool make_geodesic_planar(Geometry &geom, const Geometry &base, int m,
  * \param m the first pattern specifier.
  * \param n the second pattern specifier.
  * \param cent the centre of projection.
+ * \param num_threads the number of threads to fill the base faces, or
+ *  \c 0 for the number of processors.
  * \return \c true if the pattern was valid, otherwise \c false. */
 bool make_geodesic_sphere(Geometry &geom, const Geometry &base, int m,
-                          int n = 0, Vec3d cent = Vec3d(0, 0, 0));
+                          int n = 0, Vec3d cent = Vec3d(0, 0, 0),
+                          int num_threads = 1);
 
 /// Project the vertices onto a sphere
 /**\param geom whose vertices will be projected
@@ -292,6 +298,47 @@ void get_coincidence_maps(const Geometry &geom, Trans3d trans,
                           std::vector<std::vector<int>> &elem_maps,
                           double eps = epsilon);
 
+/// Test whether transformations carry a geometry onto itself
+/** The geometry is indexed once, and each test then looks up the
+ *  transformed elements, with no copy of the geometry and, once the
+ *  element maps have been sized, no allocation. The geometry must not
+ *  change while the matcher is in use. Tests may be made from several
+ *  threads at once. */
+class CoincidenceMatcher {
+private:
+  const Geometry &geom;
+  double eps;
+  bool valid;
+  VertIndex vert_idx;
+  std::vector<std::pair<long long, int>> edge_keys; // sorted, with index
+  std::vector<std::vector<int>> face_keys; // lowest index first, then lower
+  std::vector<int> face_order;             // face numbers in key order
+
+public:
+  /// Constructor
+  /**\param geom the geometry to test, the matcher refers to this geometry.
+   * \param eps a small number, coordinates differing by less than eps are
+   *  the same. */
+  CoincidenceMatcher(const Geometry &geom, double eps = epsilon);
+
+  /// Check whether the geometry can be tested
+  /** Tests are not made if the geometry has vertices closer than
+   *  \c 2*eps, or unset vertices, or repeated edges or faces. Use
+   *  \c check_coincidence() for such a geometry.
+   * \return \c true if tests can be made. */
+  bool is_valid() const { return valid; }
+
+  /// Test whether a transformation carries the geometry onto itself
+  /**\param trans the transformation.
+   * \param elem_maps vector (0:vertices, 1:edges, 2:faces) of vectors
+   *  mapping each element index to the index of the element it is
+   *  carried onto. Only complete if \c true is returned.
+   * \return \c true if the transformed geometry is coincident with the
+   *  geometry, \c false if not, or if the geometry cannot be tested. */
+  bool match(const Trans3d &trans,
+             std::vector<std::vector<int>> &elem_maps) const;
+};
+
 /// Get convexity of a geometry
 /**\param geom geometry to check
  * \param eps a small number, coordinates differing by less than eps are
@@ -392,7 +439,9 @@ bool are_points_in_hull(const std::vector<Vec3d> &points, const Geometry &hull,
                         unsigned int inclusion_test, const double &eps);
 
 /// Find the index number of a vertex with a set of coordinates
-/**\param geom the geometry
+/** The vertices are searched in order, use a \c VertIndex when making
+ *  many lookups.
+ * \param geom the geometry
  * \param coords the coordinates
  * \param eps a small number, coordinates differing by less than eps are
  *  the same.
@@ -458,6 +507,16 @@ int find_edge_in_edge_list(const std::vector<std::vector<int>> &edges,
 int find_edge_by_coords(const Geometry &geom, const Vec3d &v0, const Vec3d &v1,
                         double eps = epsilon);
 
+/// Find the index number of an edge with a set of coordinates
+/**\param geom the geometry
+ * \param vert_idx an index of the geometry vertices, which sets the limit
+ *  of precision.
+ * \param v0 one edge coordinate
+ * \param v1 other edge coordinate
+ * \return The corresponding edge with lowest index number, otherwise -1 */
+int find_edge_by_coords(const Geometry &geom, const VertIndex &vert_idx,
+                        const Vec3d &v0, const Vec3d &v1);
+
 /// Find edges which do not correspond to the edge of a face
 /**\param geom the geometry
  * \return the unmatched edges. */
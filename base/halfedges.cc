@@ -0,0 +1,207 @@
+/*
+   Copyright (c) 2023, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/*!\file halfedges.cc
+   \brief Half-edge connectivity of the faces of a geometry
+*/
+
+#include "halfedges.h"
+#include "geometry.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+using std::map;
+using std::vector;
+
+namespace anti {
+
+// Make a stable counting sort of the items by key, returning the item
+// order and the start of each key group (and the total). The keys are
+// offset by key_off, which must bring them into the range 0 to num_keys-1
+static void counting_sort(const vector<int> &keys, int num_keys, int key_off,
+                          vector<int> &order, vector<int> &starts)
+{
+  starts.assign(num_keys + 1, 0);
+  for (int key : keys)
+    starts[key + key_off + 1]++;
+  for (int i = 0; i < num_keys; i++)
+    starts[i + 1] += starts[i];
+  vector<int> pos(starts.begin(), starts.end() - 1);
+  order.resize(keys.size());
+  for (unsigned int i = 0; i < keys.size(); i++)
+    order[pos[keys[i] + key_off]++] = i;
+}
+
+void HalfEdges::init(const Geometry &geom)
+{
+  const vector<vector<int>> &faces = geom.faces();
+  const int f_sz = faces.size();
+
+  // half-edges
+  f_starts.resize(f_sz + 1);
+  f_starts[0] = 0;
+  for (int f = 0; f < f_sz; f++)
+    f_starts[f + 1] = f_starts[f] + faces[f].size();
+  const int he_sz = f_starts[f_sz];
+  he_verts.resize(he_sz);
+  he_faces.resize(he_sz);
+  // vertex index numbers out of range, from bad input, are kept, and the
+  // per-vertex tables are offset to include any negative index numbers
+  int v_sz = geom.verts().size();
+  int v_min = 0;
+  for (int f = 0; f < f_sz; f++) {
+    std::copy(faces[f].begin(), faces[f].end(),
+              he_verts.begin() + f_starts[f]);
+    std::fill(he_faces.begin() + f_starts[f], he_faces.begin() + f_starts[f + 1],
+              f);
+    for (int v_idx : faces[f]) {
+      if (v_idx >= v_sz)
+        v_sz = v_idx + 1;
+      else if (v_idx < v_min)
+        v_min = v_idx;
+    }
+  }
+  v_off = -v_min;
+  const int num_keys = v_sz + v_off;
+
+  // outgoing half-edges of each vertex
+  counting_sort(he_verts, num_keys, v_off, v_hes, v_starts);
+
+  // group the half-edges by their lower vertex, and then higher vertex
+  vector<int> lows(he_sz);
+  vector<int> highs(he_sz);
+  for (int he = 0; he < he_sz; he++) {
+    const int v0 = he_verts[he];
+    const int v1 = end_vert(he);
+    lows[he] = std::min(v0, v1);
+    highs[he] = std::max(v0, v1);
+  }
+  vector<int> low_starts;
+  counting_sort(lows, num_keys, v_off, e_hes, low_starts);
+  for (int k = 0; k < num_keys; k++)
+    std::stable_sort(e_hes.begin() + low_starts[k],
+                     e_hes.begin() + low_starts[k + 1],
+                     [&](int he0, int he1) { return highs[he0] < highs[he1]; });
+
+  // number the implicit edges
+  he_edges.resize(he_sz);
+  e_verts.clear();
+  e_starts.clear();
+  v_e_starts.assign(num_keys + 1, 0);
+  for (int i = 0; i < he_sz; i++) {
+    const int he = e_hes[i];
+    if (i == 0 || lows[he] != lows[e_hes[i - 1]] ||
+        highs[he] != highs[e_hes[i - 1]]) {
+      e_starts.push_back(i);
+      e_verts.push_back(lows[he]);
+      e_verts.push_back(highs[he]);
+      v_e_starts[lows[he] + v_off + 1]++;
+    }
+    he_edges[he] = e_starts.size() - 1;
+  }
+  e_starts.push_back(he_sz);
+  for (int k = 0; k < num_keys; k++)
+    v_e_starts[k + 1] += v_e_starts[k];
+}
+
+bool HalfEdges::is_current(const Geometry &geom) const
+{
+  const vector<vector<int>> &faces = geom.faces();
+  if (faces.size() + 1 != f_starts.size())
+    return false;
+  for (unsigned int f = 0; f < faces.size(); f++)
+    if (f_starts[f + 1] - f_starts[f] != (int)faces[f].size() ||
+        !std::equal(faces[f].begin(), faces[f].end(),
+                    he_verts.begin() + f_starts[f]))
+      return false;
+  return true;
+}
+
+int HalfEdges::find_edge(int v_idx0, int v_idx1) const
+{
+  if (v_idx0 > v_idx1)
+    std::swap(v_idx0, v_idx1);
+  const int k = v_idx0 + v_off;
+  if (k < 0 || k + 1 >= (int)v_e_starts.size())
+    return -1;
+
+  // edges with the same lower vertex are ordered by the higher vertex
+  int lo = v_e_starts[k];
+  int hi = v_e_starts[k + 1];
+  while (lo < hi) {
+    const int mid = (lo + hi) / 2;
+    if (e_verts[2 * mid + 1] < v_idx1)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return (lo < v_e_starts[k + 1] && e_verts[2 * lo + 1] == v_idx1) ? lo : -1;
+}
+
+bool HalfEdges::is_oriented() const
+{
+  for (int e = 0; e < num_edges(); e++) {
+    int fwd_cnt = 0;
+    int bwd_cnt = 0;
+    for (int i = e_starts[e]; i < e_starts[e + 1]; i++) {
+      if (vert(e_hes[i]) == edge_vert(e, 0))
+        fwd_cnt++;
+      else
+        bwd_cnt++;
+    }
+    if (fwd_cnt > 1 || bwd_cnt > 1)
+      return false;
+  }
+  return true;
+}
+
+map<vector<int>, vector<int>>
+HalfEdges::get_edge_face_pairs(bool oriented) const
+{
+  map<vector<int>, vector<int>> edge2facepr;
+  vector<int> edge(2);
+  for (int e = 0; e < num_edges(); e++) {
+    edge[0] = edge_vert(e, 0);
+    edge[1] = edge_vert(e, 1);
+    // the edges are in order, so each is added at the end of the map
+    auto ei = edge2facepr.emplace_hint(edge2facepr.end(), edge, vector<int>());
+    vector<int> &e_faces = ei->second;
+    if (oriented) {
+      // a later face on the same side replaces an earlier one
+      e_faces.assign(2, -1);
+      for (int i = e_starts[e]; i < e_starts[e + 1]; i++)
+        e_faces[vert(e_hes[i]) != edge[0]] = face(e_hes[i]);
+    }
+    else {
+      e_faces.resize(edge_size(e));
+      for (int i = e_starts[e]; i < e_starts[e + 1]; i++)
+        e_faces[i - e_starts[e]] = face(e_hes[i]);
+    }
+  }
+  return edge2facepr;
+}
+
+} // namespace anti
@@ -0,0 +1,246 @@
+/*
+   Copyright (c) 2023, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/*!\file halfedges.h
+   \brief Half-edge connectivity of the faces of a geometry
+*/
+
+#ifndef HALFEDGES_H
+#define HALFEDGES_H
+
+#include <map>
+#include <vector>
+
+namespace anti {
+
+class Geometry;
+
+/// Half-edge connectivity of the faces of a geometry
+/** Each face side is a half-edge, leading from a face vertex to the next
+ *  vertex in the face. The half-edges of face \c f are numbered
+ *  consecutively from \c face_start(f), in face vertex order. The
+ *  implicit edges are numbered in ascending order of their vertex index
+ *  numbers, as in \c Geometry::get_impl_edges(), and the half-edges on
+ *  an edge, or leaving a vertex, are listed in half-edge order.
+ *
+ *  All the data is held in flat arrays, built in a single pass. The
+ *  connectivity is not updated if the faces change. Faces that visit an
+ *  edge more than once, edges with any number of faces, and vertex index
+ *  numbers outside the vertex list, are allowed.
+ */
+class HalfEdges {
+private:
+  std::vector<int> f_starts;   // first half-edge of each face, and total
+  std::vector<int> he_verts;   // start vertex of each half-edge
+  std::vector<int> he_faces;   // face of each half-edge
+  std::vector<int> he_edges;   // implicit edge of each half-edge
+  std::vector<int> e_verts;    // vertex pairs of the implicit edges
+  std::vector<int> e_starts;   // first entry in e_hes for each edge
+  std::vector<int> e_hes;      // half-edges grouped by edge
+  std::vector<int> v_starts;   // first entry in v_hes for each vertex
+  std::vector<int> v_hes;      // outgoing half-edges grouped by vertex
+  std::vector<int> v_e_starts; // first edge with each vertex as lowest
+  int v_off = 0;               // offset to vertex index in v_ tables
+
+public:
+  /// Constructor
+  HalfEdges() = default;
+
+  /// Constructor
+  /**\param geom the geometry to find the connectivity for. */
+  HalfEdges(const Geometry &geom) { init(geom); }
+
+  /// Find the connectivity
+  /**\param geom the geometry to find the connectivity for. */
+  void init(const Geometry &geom);
+
+  /// Check whether the connectivity is for the current faces of a geometry
+  /** Compares each face vertex, which is much quicker than \c init().
+   * \param geom the geometry to check.
+   * \return \c true if the faces have not changed. */
+  bool is_current(const Geometry &geom) const;
+
+  //-------------------------------------------
+  // Half-edges
+  //-------------------------------------------
+
+  /// Get the number of half-edges
+  /**\return The number of half-edges. */
+  int num_half_edges() const { return he_verts.size(); }
+
+  /// Get the first half-edge of a face
+  /**\param f_idx the face index number.
+   * \return The half-edge leaving face vertex \c 0. */
+  int face_start(int f_idx) const { return f_starts[f_idx]; }
+
+  /// Get the number of sides of a face
+  /**\param f_idx the face index number.
+   * \return The number of half-edges in the face. */
+  int face_size(int f_idx) const
+  {
+    return f_starts[f_idx + 1] - f_starts[f_idx];
+  }
+
+  /// Get the face of a half-edge
+  /**\param he the half-edge.
+   * \return The face index number. */
+  int face(int he) const { return he_faces[he]; }
+
+  /// Get the start vertex of a half-edge
+  /**\param he the half-edge.
+   * \return The vertex index number. */
+  int vert(int he) const { return he_verts[he]; }
+
+  /// Get the end vertex of a half-edge
+  /**\param he the half-edge.
+   * \return The vertex index number. */
+  int end_vert(int he) const { return he_verts[next(he)]; }
+
+  /// Get the next half-edge in a face
+  /**\param he the half-edge.
+   * \return The following half-edge. */
+  int next(int he) const
+  {
+    return (he + 1 < f_starts[he_faces[he] + 1]) ? he + 1
+                                                  : f_starts[he_faces[he]];
+  }
+
+  /// Get the previous half-edge in a face
+  /**\param he the half-edge.
+   * \return The preceding half-edge. */
+  int prev(int he) const
+  {
+    return (he > f_starts[he_faces[he]]) ? he - 1
+                                          : f_starts[he_faces[he] + 1] - 1;
+  }
+
+  /// Get the implicit edge of a half-edge
+  /**\param he the half-edge.
+   * \return The implicit edge index number. */
+  int edge(int he) const { return he_edges[he]; }
+
+  /// Get the partner of a half-edge
+  /**\param he the half-edge.
+   * \return The other half-edge on the edge, or \c -1 if the edge does not
+   *  have exactly two half-edges. */
+  int partner(int he) const
+  {
+    const int e = he_edges[he];
+    if (e_starts[e + 1] - e_starts[e] != 2)
+      return -1;
+    return (e_hes[e_starts[e]] != he) ? e_hes[e_starts[e]]
+                                      : e_hes[e_starts[e] + 1];
+  }
+
+  /// Check whether a half-edge leads from the lower vertex index number
+  /**\param he the half-edge.
+   * \return \c true if the start vertex is the lower. */
+  bool is_forward(int he) const { return vert(he) < end_vert(he); }
+
+  //-------------------------------------------
+  // Implicit edges
+  //-------------------------------------------
+
+  /// Get the number of implicit edges
+  /**\return The number of implicit edges. */
+  int num_edges() const { return e_verts.size() / 2; }
+
+  /// Get a vertex of an implicit edge
+  /**\param e_idx the implicit edge index number.
+   * \param v_no \c 0 for the lower vertex index number, \c 1 for the higher.
+   * \return The vertex index number. */
+  int edge_vert(int e_idx, int v_no) const { return e_verts[2 * e_idx + v_no]; }
+
+  /// Get the number of half-edges on an implicit edge
+  /**\param e_idx the implicit edge index number.
+   * \return The number of half-edges, which is the number of face sides
+   *  on the edge. */
+  int edge_size(int e_idx) const
+  {
+    return e_starts[e_idx + 1] - e_starts[e_idx];
+  }
+
+  /// Get a half-edge on an implicit edge
+  /**\param e_idx the implicit edge index number.
+   * \param n the position in the half-edge list for the edge.
+   * \return The half-edge. */
+  int edge_half_edge(int e_idx, int n) const
+  {
+    return e_hes[e_starts[e_idx] + n];
+  }
+
+  /// Find an implicit edge
+  /**\param v_idx0 a vertex index number.
+   * \param v_idx1 another vertex index number.
+   * \return The implicit edge index number, or \c -1 if the vertices are
+   *  not joined by a face side. */
+  int find_edge(int v_idx0, int v_idx1) const;
+
+  //-------------------------------------------
+  // Vertices
+  //-------------------------------------------
+
+  /// Get the number of half-edges leaving a vertex
+  /**\param v_idx the vertex index number.
+   * \return The number of half-edges. */
+  int vert_size(int v_idx) const
+  {
+    const int k = v_idx + v_off;
+    return (k >= 0 && k + 1 < (int)v_starts.size())
+               ? v_starts[k + 1] - v_starts[k]
+               : 0;
+  }
+
+  /// Get a half-edge leaving a vertex
+  /**\param v_idx the vertex index number.
+   * \param n the position in the half-edge list for the vertex.
+   * \return The half-edge. */
+  int vert_half_edge(int v_idx, int n) const
+  {
+    return v_hes[v_starts[v_idx + v_off] + n];
+  }
+
+  //-------------------------------------------
+  // Compatibility
+  //-------------------------------------------
+
+  /// Check whether the faces are consistently oriented
+  /**\return \c true if no two face sides lead in the same direction
+   *  between the same pair of vertices. */
+  bool is_oriented() const;
+
+  /// Get faces lying on each side of an edge for all edges
+  /** Gives the same result as \c Geometry::get_edge_face_pairs()
+   * \param oriented \c true the first face in the face pair has the
+   *  vertices of the edge pair in order, -1 for a face index indicates
+   *  the edge is open to that side. \c false the value is a list of all
+   *  faces sharing the edge, in half-edge order.
+   * \return A map of edges to face pairs.*/
+  std::map<std::vector<int>, std::vector<int>>
+  get_edge_face_pairs(bool oriented = true) const;
+};
+
+} // namespace anti
+
+#endif // HALFEDGES_H
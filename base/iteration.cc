@@ -29,6 +29,7 @@
 #include "../base/iteration.h"
 #include "../base/utils.h"
 
+#include <algorithm>
 #include <cstdarg>
 #include <cstdio>
 #include <limits>
@@ -123,6 +124,32 @@ Status IterationControl::set_sig_digits(int digits)
   return stat;
 }
 
+Status IterationControl::set_accel_depth(int depth)
+{
+  Status stat;
+  if (depth < 0)
+    stat.set_error("number of iterations for acceleration cannot be negative");
+  else {
+    accel_depth = depth;
+    if (depth > 50)
+      stat.set_warning("large number of iterations for acceleration, "
+                       "iteration may be slow");
+  }
+
+  return stat;
+}
+
+Status IterationControl::set_num_threads(int threads)
+{
+  Status stat;
+  if (threads < 0)
+    stat.set_error("number of threads cannot be negative");
+  else
+    num_threads = threads;
+
+  return stat;
+}
+
 int IterationControl::print(const char *fmt, ...) const
 {
   int ret = 0;
@@ -135,4 +162,149 @@ int IterationControl::print(const char *fmt, ...) const
   return ret;
 }
 
+// Solve a*x = b by Gaussian elimination with partial pivoting, a is a
+// square matrix of dimension b.size() stored by rows, x is returned in b
+static bool solve_linear(std::vector<double> &a, std::vector<double> &b)
+{
+  const int n = b.size();
+  for (int col = 0; col < n; col++) {
+    int pivot = col;
+    for (int row = col + 1; row < n; row++)
+      if (fabs(a[row * n + col]) > fabs(a[pivot * n + col]))
+        pivot = row;
+    if (a[pivot * n + col] == 0.0)
+      return false;
+    if (pivot != col) {
+      for (int i = col; i < n; i++)
+        std::swap(a[col * n + i], a[pivot * n + i]);
+      std::swap(b[col], b[pivot]);
+    }
+    for (int row = col + 1; row < n; row++) {
+      const double mult = a[row * n + col] / a[col * n + col];
+      for (int i = col; i < n; i++)
+        a[row * n + i] -= mult * a[col * n + i];
+      b[row] -= mult * b[col];
+    }
+  }
+
+  for (int row = n - 1; row >= 0; row--) {
+    for (int i = row + 1; i < n; i++)
+      b[row] -= a[row * n + i] * b[i];
+    b[row] /= a[row * n + row];
+  }
+  return true;
+}
+
+static double dot(const std::vector<Vec3d> &v0, const std::vector<Vec3d> &v1)
+{
+  double sum = 0;
+  for (size_t i = 0; i < v0.size(); i++)
+    sum += vdot(v0[i], v1[i]);
+  return sum;
+}
+
+AndersonAccel::AndersonAccel(int depth)
+    : depth(std::max(depth, 0)), d_fs(this->depth), d_gs(this->depth)
+{
+}
+
+void AndersonAccel::clear()
+{
+  num_hist = 0;
+  next_hist = 0;
+  f_last.clear();
+  g_last.clear();
+}
+
+void AndersonAccel::update(const std::vector<Vec3d> &x, std::vector<Vec3d> &gx)
+{
+  // clear history if the step length grows by this factor (squared)
+  const double restart_ratio2 = 100;
+  // regularisation of the least squares problem, relative to its size
+  const double regularise = 1e-12;
+
+  if (!is_active())
+    return;
+
+  const size_t sz = x.size();
+  if (f_last.size() != sz)
+    clear();
+
+  // f is the step taken by the plain iteration
+  f.resize(sz);
+  double f_len2 = 0;
+  for (size_t i = 0; i < sz; i++) {
+    f[i] = gx[i] - x[i];
+    f_len2 += f[i].len2();
+  }
+
+  if (!f_last.empty()) {
+    if (f_len2 > f_last_len2 * restart_ratio2) {
+      num_hist = 0;
+      next_hist = 0;
+    }
+    else {
+      auto &d_f = d_fs[next_hist];
+      auto &d_g = d_gs[next_hist];
+      d_f.resize(sz);
+      d_g.resize(sz);
+      for (size_t i = 0; i < sz; i++) {
+        d_f[i] = f[i] - f_last[i];
+        d_g[i] = gx[i] - g_last[i];
+      }
+      next_hist = (next_hist + 1) % depth;
+      num_hist = std::min(num_hist + 1, depth);
+    }
+  }
+  f_last = f;
+  g_last = gx;
+  f_last_len2 = f_len2;
+
+  if (num_hist == 0)
+    return;
+
+  // Find the combination of previous step changes that best cancels the
+  // current step, by solving the normal equations of the least squares
+  const int n = num_hist;
+  mat.resize(n * n);
+  coeffs.resize(n);
+  double max_diag = 0;
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j <= i; j++)
+      mat[i * n + j] = mat[j * n + i] = dot(d_fs[i], d_fs[j]);
+    max_diag = std::max(max_diag, mat[i * n + i]);
+    coeffs[i] = dot(d_fs[i], f);
+  }
+  for (int i = 0; i < n; i++)
+    mat[i * n + i] += max_diag * regularise;
+
+  if (max_diag == 0.0 || !solve_linear(mat, coeffs)) {
+    num_hist = 0;
+    next_hist = 0;
+    return;
+  }
+
+  for (int i = 0; i < n; i++)
+    for (size_t j = 0; j < sz; j++)
+      gx[j] -= coeffs[i] * d_gs[i][j];
+}
+
+void AndersonAccel::update_offsets(const std::vector<Vec3d> &pts,
+                                   std::vector<Vec3d> &offsets,
+                                   const std::vector<int> &idxs)
+{
+  if (!is_active())
+    return;
+
+  sel_x.resize(idxs.size());
+  sel_gx.resize(idxs.size());
+  for (size_t i = 0; i < idxs.size(); i++) {
+    sel_x[i] = pts[idxs[i]];
+    sel_gx[i] = pts[idxs[i]] + offsets[idxs[i]];
+  }
+  update(sel_x, sel_gx);
+  for (size_t i = 0; i < idxs.size(); i++)
+    offsets[idxs[i]] = sel_gx[i] - sel_x[i];
+}
+
 }; // namespace anti
@@ -30,9 +30,11 @@
 #define ITERATION_H
 
 #include <cmath>
+#include <vector>
 
 #include "const.h"
 #include "status.h"
+#include "vec3d.h"
 
 namespace anti {
 
@@ -97,6 +99,28 @@ public:
   /**\return number of significant digits. */
   int get_sig_digits() const { return sig_digits; }
 
+  /// Set number of previous iterations used for acceleration
+  /**\param depth the number of previous iterations to use for Anderson
+   *  acceleration, or 0 for no acceleration
+   * \return status, an error if the depth is negative, or a warning
+   *  if it is large enough to slow the iteration.*/
+  Status set_accel_depth(int depth);
+
+  /// Get number of previous iterations used for acceleration
+  /**\return number of previous iterations, 0 for no acceleration. */
+  int get_accel_depth() const { return accel_depth; }
+
+  /// Set number of threads to use for the iteration calculations
+  /**\param threads the number of threads, or 0 for the number of
+   *  processors
+   * \return status, evaluates to \c true if the number of threads
+   *  is not negative, otherwise \c false.*/
+  Status set_num_threads(int threads);
+
+  /// Get number of threads to use for the iteration calculations
+  /**\return number of threads, or 0 for the number of processors. */
+  int get_num_threads() const { return num_threads; }
+
   /// Set output stream for reporting
   /**\param strm output stream (or nullptr for no reporting)*/
   void set_stream(FILE *strm) { stream = strm; }
@@ -198,10 +222,62 @@ private:
   int status_check_and_report_iters = 1000;
   int status_check_only_iters = 0;
   int sig_digits = 13;
+  int accel_depth = 0;
+  int num_threads = 1;
   FILE *stream = stderr;
   bool finished = false;
 };
 
+/// Anderson acceleration for fixed point iterations
+/**An iteration that repeatedly replaces a set of points \c x with \c g(x)
+ * can pass both to \c update(), which mixes in the changes from previous
+ * iterations to give a point closer to the fixed point. The history is
+ * cleared if the size of the change grows sharply. */
+class AndersonAccel {
+public:
+  /// Constructor
+  /**\param depth the number of previous iterations to use, or 0 for
+   *  no acceleration (\c update() leaves the points unchanged.) */
+  AndersonAccel(int depth = 0);
+
+  /// Is acceleration being used
+  /**\return \c true if the depth is greater than 0. */
+  bool is_active() const { return depth > 0; }
+
+  /// Clear the history of previous iterations
+  void clear();
+
+  /// Accelerate an iteration
+  /**\param x the points at the start of the iteration.
+   * \param gx the points after the iteration, these are replaced by
+   *  the accelerated points. */
+  void update(const std::vector<Vec3d> &x, std::vector<Vec3d> &gx);
+
+  /// Accelerate an iteration that moves points by offsets
+  /**\param pts the points at the start of the iteration.
+   * \param offsets the offsets to move the points by, the offsets of the
+   *  iterated points are replaced by the accelerated offsets.
+   * \param idxs the index numbers of the iterated points. */
+  void update_offsets(const std::vector<Vec3d> &pts,
+                      std::vector<Vec3d> &offsets,
+                      const std::vector<int> &idxs);
+
+private:
+  int depth;
+  int num_hist = 0;  // number of differences held
+  int next_hist = 0; // slot to hold the next differences
+  double f_last_len2 = 0;
+  std::vector<std::vector<Vec3d>> d_fs; // changes in the step
+  std::vector<std::vector<Vec3d>> d_gs; // changes in the iterated points
+  std::vector<Vec3d> f;
+  std::vector<Vec3d> f_last;
+  std::vector<Vec3d> g_last;
+  std::vector<Vec3d> sel_x; // iterated points for update_offsets()
+  std::vector<Vec3d> sel_gx;
+  std::vector<double> mat;
+  std::vector<double> coeffs;
+};
+
 }; // namespace anti
 
 #endif // ITERATION_H
@@ -222,7 +222,8 @@ void J6(Geometry &geom)
       del_verts.push_back(i);
   geom.del(VERTS, del_verts);
   close_poly_basic(geom);
-  swap(geom.faces(0), geom.faces(16)); // large face to 0, the def bonding face
+  swap(geom.raw_faces(0),
+       geom.raw_faces(16)); // large face to 0, the def bonding face
 }
 
 // elongated triangular pyramid
@@ -0,0 +1,425 @@
+/*
+   Copyright (c) 2023, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/* \file off_binary.cc
+   \brief Read and write binary OFF files
+
+   Layout, all numbers little-endian:
+     magic            8 bytes, off_binary_magic
+     version          uint32
+     flags            uint32, bit 0/1/2 set if V/E/F colours follow
+     vertex count     uint64
+     edge count       uint64
+     face count       uint64
+     face index count uint64
+     vertices         3 float64 for each vertex
+     face starts      uint64 for each face and the end of the last face
+     face indexes     int32 for each face vertex
+     edges            2 int32 for each edge
+     colours          for each V/E/F flag: uint64 count, then for each
+                      colour int32 element index, int32 colour index
+                      (-1 for a colour value) and 4 bytes RGBA
+*/
+
+#include "private_off_file.h"
+#include "utils.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+using std::string;
+using std::vector;
+
+const char off_binary_magic[] = "\x89OFFBIN\n";
+static const unsigned int off_binary_version = 1;
+
+// don't export these functions
+namespace {
+
+const int magic_len = sizeof(off_binary_magic) - 1;
+
+// Buffer binary data, writing it to the file in large chunks
+class BinWriter {
+private:
+  FILE *ofile;
+  vector<unsigned char> buf;
+  size_t pos = 0;
+
+public:
+  BinWriter(FILE *ofile) : ofile(ofile), buf(1 << 16) {}
+  ~BinWriter() { flush(); }
+
+  void flush()
+  {
+    if (pos)
+      fwrite(buf.data(), 1, pos, ofile);
+    pos = 0;
+  }
+
+  void add_bytes(const void *data, size_t len)
+  {
+    if (pos + len > buf.size())
+      flush();
+    if (len > buf.size()) {
+      fwrite(data, 1, len, ofile);
+      return;
+    }
+    memcpy(buf.data() + pos, data, len);
+    pos += len;
+  }
+
+  void add_u64(unsigned long long val)
+  {
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; i++)
+      bytes[i] = (unsigned char)(val >> (8 * i));
+    add_bytes(bytes, 8);
+  }
+
+  void add_u32(unsigned int val)
+  {
+    unsigned char bytes[4];
+    for (int i = 0; i < 4; i++)
+      bytes[i] = (unsigned char)(val >> (8 * i));
+    add_bytes(bytes, 4);
+  }
+
+  void add_i32(int val) { add_u32((unsigned int)val); }
+
+  void add_f64(double val)
+  {
+    unsigned long long bits;
+    memcpy(&bits, &val, sizeof(bits));
+    add_u64(bits);
+  }
+};
+
+// Read binary data, checking for the end of the file
+class BinReader {
+private:
+  FILE *ifile;
+  bool failed = false;
+
+public:
+  BinReader(FILE *ifile) : ifile(ifile) {}
+
+  bool is_ok() const { return !failed; }
+
+  bool get_bytes(void *data, size_t len)
+  {
+    if (!failed && fread(data, 1, len, ifile) != len)
+      failed = true;
+    return !failed;
+  }
+
+  unsigned long long get_u64()
+  {
+    unsigned char bytes[8] = {0};
+    get_bytes(bytes, 8);
+    unsigned long long val = 0;
+    for (int i = 0; i < 8; i++)
+      val |= (unsigned long long)bytes[i] << (8 * i);
+    return val;
+  }
+
+  unsigned int get_u32()
+  {
+    unsigned char bytes[4] = {0};
+    get_bytes(bytes, 4);
+    unsigned int val = 0;
+    for (int i = 0; i < 4; i++)
+      val |= (unsigned int)bytes[i] << (8 * i);
+    return val;
+  }
+
+  int get_i32() { return (int)get_u32(); }
+
+  double get_f64()
+  {
+    unsigned long long bits = get_u64();
+    double val;
+    memcpy(&val, &bits, sizeof(val));
+    return val;
+  }
+};
+
+// Counts are limited so that element numbers fit in an int
+const unsigned long long max_elems = 0x7fffffff;
+
+void write_cols(BinWriter &out, const vector<const Geometry *> &geoms,
+                int type)
+{
+  unsigned long long cnt = 0;
+  for (auto geom : geoms)
+    cnt += geom->colors(type).size();
+  out.add_u64(cnt);
+
+  int offset = 0;
+  for (auto geom : geoms) {
+    for (const auto &kp : geom->colors(type)) {
+      const Color &col = kp.second;
+      out.add_i32(kp.first + offset);
+      out.add_i32(col.is_index() ? col.get_index() : -1);
+      unsigned char rgba[4] = {0, 0, 0, 0};
+      if (col.is_value())
+        for (int i = 0; i < 4; i++)
+          rgba[i] = col[i];
+      out.add_bytes(rgba, 4);
+    }
+    offset += (type == VERTS)   ? geom->verts().size()
+              : (type == EDGES) ? geom->edges().size()
+                                : geom->faces().size();
+  }
+}
+
+Status read_cols(BinReader &in, Geometry &geom, int type, int num_elems)
+{
+  const char *elem_str[] = {"vertex", "edge", "face"};
+  const unsigned long long cnt = in.get_u64();
+  if (cnt > (unsigned long long)num_elems)
+    return Status::error(
+        msg_str("%s colours: more colours than elements", elem_str[type]));
+
+  for (unsigned long long i = 0; i < cnt && in.is_ok(); i++) {
+    const int idx = in.get_i32();
+    const int col_idx = in.get_i32();
+    unsigned char rgba[4];
+    in.get_bytes(rgba, 4);
+    if (!in.is_ok())
+      break;
+    if (idx < 0 || idx >= num_elems)
+      return Status::error(msg_str("%s colours: element index '%d' is not "
+                                   "in range 0 to %d",
+                                   elem_str[type], idx, num_elems - 1));
+    if (col_idx >= 0)
+      geom.colors(type).set(idx, Color(col_idx));
+    else
+      geom.colors(type).set(idx, Color(rgba[0], rgba[1], rgba[2], rgba[3]));
+  }
+
+  return Status::ok();
+}
+
+} // namespace
+
+bool off_binary_output(const string &file_name)
+{
+  const string suffix = ".offb";
+  if (file_name.size() >= suffix.size() &&
+      file_name.compare(file_name.size() - suffix.size(), suffix.size(),
+                        suffix) == 0)
+    return true;
+
+  if (file_name == "") { // standard output
+    const char *env = getenv("ANTIPRISM_OFF_BINARY");
+    return env && *env && strcmp(env, "0") != 0;
+  }
+
+  return false;
+}
+
+void off_binary_set_mode(FILE *file)
+{
+#ifdef _WIN32
+  // the standard streams start in text mode, which translates line endings
+  if (file == stdout)
+    fflush(file);
+  if (file == stdin || file == stdout)
+    _setmode(_fileno(file), _O_BINARY);
+#else
+  (void)file;
+#endif
+}
+
+void off_binary_write(FILE *ofile, const vector<const Geometry *> &geoms)
+{
+  unsigned long long num_verts = 0;
+  unsigned long long num_edges = 0;
+  unsigned long long num_faces = 0;
+  unsigned long long num_idxs = 0;
+  unsigned int flags = 0;
+  for (auto geom : geoms) {
+    num_verts += geom->verts().size();
+    num_edges += geom->edges().size();
+    num_faces += geom->faces().size();
+    for (const auto &face : geom->faces())
+      num_idxs += face.size();
+    for (int type : {VERTS, EDGES, FACES})
+      if (geom->colors(type).size())
+        flags |= 1 << type;
+  }
+
+  off_binary_set_mode(ofile);
+  BinWriter out(ofile);
+  out.add_bytes(off_binary_magic, magic_len);
+  out.add_u32(off_binary_version);
+  out.add_u32(flags);
+  out.add_u64(num_verts);
+  out.add_u64(num_edges);
+  out.add_u64(num_faces);
+  out.add_u64(num_idxs);
+
+  for (auto geom : geoms)
+    for (const auto &v : geom->verts())
+      for (int i = 0; i < 3; i++)
+        out.add_f64(v[i]);
+
+  unsigned long long start = 0;
+  for (auto geom : geoms)
+    for (const auto &face : geom->faces()) {
+      out.add_u64(start);
+      start += face.size();
+    }
+  out.add_u64(start);
+
+  int offset = 0;
+  for (auto geom : geoms) {
+    for (const auto &face : geom->faces())
+      for (int v_idx : face)
+        out.add_i32(v_idx + offset);
+    offset += geom->verts().size();
+  }
+
+  offset = 0;
+  for (auto geom : geoms) {
+    for (const auto &edge : geom->edges())
+      for (int i = 0; i < 2; i++)
+        out.add_i32(edge[i] + offset);
+    offset += geom->verts().size();
+  }
+
+  for (int type : {VERTS, EDGES, FACES})
+    if (flags & (1 << type))
+      write_cols(out, geoms, type);
+}
+
+static Status read_elems(BinReader &in, Geometry &geom)
+{
+  const unsigned int version = in.get_u32();
+  const unsigned int flags = in.get_u32();
+  const unsigned long long num_verts = in.get_u64();
+  const unsigned long long num_edges = in.get_u64();
+  const unsigned long long num_faces = in.get_u64();
+  const unsigned long long num_idxs = in.get_u64();
+  if (!in.is_ok())
+    return Status::error("binary OFF: header: unexpected end of file");
+
+  if (version != off_binary_version)
+    return Status::error(
+        msg_str("binary OFF: header: unsupported version %u", version));
+
+  if (num_verts > max_elems || num_edges > max_elems ||
+      num_faces > max_elems || num_idxs > max_elems)
+    return Status::error("binary OFF: header: element count is too large");
+
+  if (num_verts == 0 && (num_faces || num_edges))
+    return Status::error("binary OFF: header: cannot have a positive face "
+                         "or edge count if vertex count is zero");
+
+  // elements are read incrementally, so the counts cannot cause a large
+  // allocation unless the data is present
+  const int last_vert = num_verts - 1;
+  for (unsigned long long i = 0; i < num_verts && in.is_ok(); i++) {
+    Vec3d v;
+    for (int j = 0; j < 3; j++)
+      v[j] = in.get_f64();
+    geom.add_vert(v);
+  }
+
+  vector<unsigned long long> starts;
+  for (unsigned long long i = 0; i <= num_faces && in.is_ok(); i++) {
+    starts.push_back(in.get_u64());
+    if (starts.back() > num_idxs || (i && starts[i] < starts[i - 1]))
+      return Status::error(
+          msg_str("binary OFF: face %llu: invalid face start", i));
+  }
+  if (in.is_ok() && starts[0] != 0)
+    return Status::error("binary OFF: face 0: invalid face start");
+  if (in.is_ok() && starts.back() != num_idxs)
+    return Status::error(
+        msg_str("binary OFF: face %llu: invalid face start", num_faces));
+
+  vector<int> face;
+  for (unsigned long long i = 0; i < num_faces && in.is_ok(); i++) {
+    face.resize(starts[i + 1] - starts[i]);
+    for (int &v_idx : face) {
+      v_idx = in.get_i32();
+      if (in.is_ok() && (v_idx < 0 || v_idx > last_vert))
+        return Status::error(
+            msg_str("binary OFF: face %llu: face index '%d' is not in "
+                    "range 0 to %d",
+                    i, v_idx, last_vert));
+    }
+    geom.raw_faces().push_back(face);
+  }
+
+  for (unsigned long long i = 0; i < num_edges && in.is_ok(); i++) {
+    vector<int> edge(2);
+    for (int &v_idx : edge) {
+      v_idx = in.get_i32();
+      if (in.is_ok() && (v_idx < 0 || v_idx > last_vert))
+        return Status::error(
+            msg_str("binary OFF: edge %llu: edge index '%d' is not in "
+                    "range 0 to %d",
+                    i, v_idx, last_vert));
+    }
+    geom.raw_edges().push_back(edge);
+  }
+
+  const int elem_cnts[] = {(int)num_verts, (int)num_edges, (int)num_faces};
+  for (int type : {VERTS, EDGES, FACES}) {
+    if (flags & (1 << type)) {
+      Status stat = read_cols(in, geom, type, elem_cnts[type]);
+      if (!stat)
+        return Status::error("binary OFF: " + stat.msg());
+    }
+  }
+
+  if (!in.is_ok())
+    return Status::error("binary OFF: unexpected end of file");
+
+  return Status::ok();
+}
+
+Status off_binary_read(FILE *ifile, Geometry &geom)
+{
+  geom.clear_all();
+  BinReader in(ifile);
+  Status stat = read_elems(in, geom);
+  if (stat.is_error())
+    geom.clear_all();
+  else if (!geom.is_set())
+    stat.set_error("no vertices (empty geometry)");
+
+  return stat;
+}
@@ -32,9 +32,11 @@
 #include "utils.h"
 
 #include <algorithm>
+#include <cfloat>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -88,12 +90,176 @@ Status off_file_read(string file_name, Geometry &geom)
   return stat;
 }
 
+// Read lines from a file in large blocks, returning each line in place
+class OffLineReader {
+private:
+  FILE *ifile;
+  vector<char> buf;
+  size_t start = 0; // start of the unread data
+  size_t end = 0;   // end of the data read from the file
+  bool at_eof = false;
+
+public:
+  OffLineReader(FILE *ifile) : ifile(ifile), buf(1 << 20) {}
+
+  // Get the next line, with any comment removed, returning 0 if a line
+  // was read, 1 at the end of the file, or -1 on error. The line is valid
+  // until the next call.
+  int get_line(char **line);
+};
+
+int OffLineReader::get_line(char **line)
+{
+  size_t line_end;
+  while (true) {
+    char *nl = (char *)memchr(buf.data() + start, '\n', end - start);
+    if (nl) {
+      line_end = nl - buf.data();
+      break;
+    }
+    if (at_eof) {
+      if (start == end)
+        return ferror(ifile) ? -1 : 1;
+      line_end = end; // final line without a newline
+      break;
+    }
+
+    // move the partial line to the front and read more data, always
+    // leaving room to terminate a final line
+    if (start > 0) {
+      memmove(buf.data(), buf.data() + start, end - start);
+      end -= start;
+      start = 0;
+    }
+    if (end + 1 >= buf.size())
+      buf.resize(buf.size() * 2);
+    size_t cnt = fread(buf.data() + end, 1, buf.size() - 1 - end, ifile);
+    end += cnt;
+    if (cnt == 0)
+      at_eof = true;
+  }
+
+  buf[line_end] = '\0';
+  *line = buf.data() + start;
+  start = (line_end < end) ? line_end + 1 : end;
+
+  char *first_hash = strchr(*line, '#');
+  if (first_hash)
+    *first_hash = '\0';
+  return 0;
+}
+
+// Powers of ten that are exactly representable as doubles
+static const double exact_pow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                     1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                     1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Read a plain decimal number, giving the same value as sscanf. A number
+// with a significand that is exact as a double, and a power of ten that is
+// exact as a double, is converted with a single correctly rounded
+// multiplication or division. Other plain decimal numbers are converted
+// with strtod(). Otherwise, or if the number is too large, return false,
+// and the number should be read with read_double_noparse(), which also
+// sets any error message.
+static bool read_double_fast(const char *str, double *f)
+{
+  const char *p = str;
+  const bool neg = (*p == '-');
+  if (*p == '-' || *p == '+')
+    p++;
+
+  unsigned long long mant = 0;
+  int sig_digits = 0;
+  int exp10 = 0;
+  bool has_digits = false;
+  for (; *p >= '0' && *p <= '9'; p++) {
+    has_digits = true;
+    if (mant || *p != '0') {
+      if (++sig_digits <= 19)
+        mant = mant * 10 + (*p - '0');
+      else
+        exp10++;
+    }
+  }
+  if (*p == '.') {
+    for (p++; *p >= '0' && *p <= '9'; p++) {
+      has_digits = true;
+      if (mant || *p != '0') {
+        if (++sig_digits <= 19) {
+          mant = mant * 10 + (*p - '0');
+          exp10--;
+        }
+      }
+      else
+        exp10--;
+    }
+  }
+  if (!has_digits)
+    return false;
+
+  if (*p == 'e' || *p == 'E') {
+    p++;
+    const bool exp_neg = (*p == '-');
+    if (*p == '-' || *p == '+')
+      p++;
+    if (!(*p >= '0' && *p <= '9'))
+      return false;
+    int exp_val = 0;
+    for (; *p >= '0' && *p <= '9'; p++)
+      if (exp_val < 1000)
+        exp_val = exp_val * 10 + (*p - '0');
+    exp10 += (exp_neg) ? -exp_val : exp_val;
+  }
+
+  if (*p != '\0')
+    return false;
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+  if (sig_digits <= 19 && mant <= (1ULL << 53) && exp10 >= -22 &&
+      exp10 <= 22) {
+    double val = (double)mant;
+    val = (exp10 < 0) ? val / exact_pow10[-exp10] : val * exact_pow10[exp10];
+    *f = (neg) ? -val : val;
+    return true;
+  }
+#endif
+
+  *f = strtod(str, nullptr);
+  return !std::isinf(*f);
+}
+
+// Read a plain integer of up to nine digits. Otherwise return false, and
+// the number should be read with read_int(), which also sets any error
+// message.
+static bool read_int_fast(const char *str, int *i)
+{
+  const char *p = str;
+  const bool neg = (*p == '-');
+  if (*p == '-' || *p == '+')
+    p++;
+
+  int val = 0;
+  int digits = 0;
+  for (; *p >= '0' && *p <= '9'; p++) {
+    if (++digits > 9)
+      return false;
+    val = val * 10 + (*p - '0');
+  }
+  if (!digits || *p != '\0')
+    return false;
+
+  *i = (neg) ? -val : val;
+  return true;
+}
+
 Status add_vert(Geometry &geom, const vector<char *> &vals)
 {
   Status stat;
   Vec3d v;
   for (unsigned int i = 0; (i < vals.size() && i < 3); i++) {
-    if (!(stat = read_double_noparse(vals[i], &v[i])))
+    if (!read_double_fast(vals[i], &v[i]) &&
+        !(stat = read_double_noparse(vals[i], &v[i])))
       return Status::error(
           msg_str("vertex coords: '%s' %s", vals[i], stat.c_msg()));
   }
@@ -106,15 +272,16 @@ Status add_vert(Geometry &geom, const vector<char *> &vals)
   return Status::ok();
 }
 
-Status add_face(Geometry &geom, vector<char *> vals, Geometry &alt_cols,
-                bool *contains_int_gt_1, bool *contains_adj_equal_idx)
+Status add_face(Geometry &geom, const vector<char *> &vals, vector<int> &face,
+                Geometry &alt_cols, bool *contains_int_gt_1,
+                bool *contains_adj_equal_idx)
 {
   Status stat;
   int face_sz;
   if (!vals.size())
     return Status::error("face: no face data");
 
-  if (!(stat = read_int(vals[0], &face_sz)))
+  if (!read_int_fast(vals[0], &face_sz) && !(stat = read_int(vals[0], &face_sz)))
     return Status::error(msg_str("face size: '%s' %s", vals[0], stat.c_msg()));
 
   if (face_sz < 1)
@@ -122,13 +289,14 @@ Status add_face(Geometry &geom, vector<char *> vals, Geometry &alt_cols,
         msg_str("face size: '%d', must be 1 or more", face_sz));
 
   *contains_adj_equal_idx = false;
-  vector<int> face(face_sz);
+  face.assign(face_sz, 0);
+  const int last_vert = geom.verts().size() - 1;
   for (unsigned int i = 1; (i < vals.size() && (int)i <= face_sz); i++) {
-    if (!(stat = read_int(vals[i], &face[i - 1])))
+    if (!read_int_fast(vals[i], &face[i - 1]) &&
+        !(stat = read_int(vals[i], &face[i - 1])))
       return Status::error(
           msg_str("face index: '%s' %s", vals[i], stat.c_msg()));
 
-    int last_vert = geom.verts().size() - 1;
     if (face[i - 1] < 0 || face[i - 1] > last_vert)
       return Status::error(msg_str("face index: '%s' is not in range 0 to %d",
                                    vals[i], last_vert));
@@ -142,43 +310,89 @@ Status add_face(Geometry &geom, vector<char *> vals, Geometry &alt_cols,
   if ((int)vals.size() - 1 < face_sz)
     return Status::error(msg_str("face: less than %d values", face_sz));
 
-  vals.erase(vals.begin(), vals.begin() + face_sz + 1);
-  int col_type;
+  int col_type = 0;
   Color col, alt_col;
-  if (!(stat = col.from_offvals(vals, &col_type)))
-    return Status::error(
-        msg_str("face colour: invalid colour: %s", stat.c_msg()));
+  if ((int)vals.size() > face_sz + 1) { // colour values follow the indexes
+    vector<char *> col_vals(vals.begin() + face_sz + 1, vals.end());
+    if (!(stat = col.from_offvals(col_vals, &col_type)))
+      return Status::error(
+          msg_str("face colour: invalid colour: %s", stat.c_msg()));
+  }
 
-  alt_col = col;
+  // the alternative colour is only stored if it differs from the colour
+  bool has_alt_col = false;
   if (col_type == 3 || col_type == 4) { // read as integers
     if (col[0] > 1 || col[1] > 1 || col[2] > 1 || (col_type == 4 && col[3] > 1))
       *contains_int_gt_1 = true;
-    else // store alternative colour with integres taken as floats
+    else { // store alternative colour with integres taken as floats
       alt_col = Color(col[0] * 255, col[1] * 255, col[2] * 255,
                       col_type == 4 ? col[3] * 255 : 255);
+      has_alt_col = true;
+    }
   }
 
   int idx;
   if (face_sz == 1) { // vertex element, only need to set colour
     geom.colors(VERTS).set(face[0], col);
-    alt_cols.colors(VERTS).set(face[0], alt_col);
+    if (has_alt_col)
+      alt_cols.colors(VERTS).set(face[0], alt_col);
+    else
+      alt_cols.colors(VERTS).del(face[0]);
   }
   else if (face_sz == 2) { // digon edge element
     idx = geom.add_edge(face);
     geom.colors(EDGES).set(idx, col);
-    alt_cols.colors(EDGES).set(idx, alt_col);
+    if (has_alt_col)
+      alt_cols.colors(EDGES).set(idx, alt_col);
+    else
+      alt_cols.colors(EDGES).del(idx);
   }
-  else { // face element
+  else { // face element, a new face has no colour to clear
     idx = geom.add_face(face);
-    geom.colors(FACES).set(idx, col);
-    alt_cols.colors(FACES).set(idx, alt_col);
+    if (col.is_set())
+      geom.colors(FACES).set(idx, col);
+    if (has_alt_col)
+      alt_cols.colors(FACES).set(idx, alt_col);
+  }
+
+  return Status::ok();
+}
+
+// Check for the binary OFF magic number, which starts with a byte that
+// does not begin a text OFF file, so only that byte need be put back
+static Status check_binary_magic(FILE *ifile, bool *is_binary)
+{
+  *is_binary = false;
+  int c = getc(ifile);
+  if (c == EOF)
+    return Status::ok();
+  if (c != (unsigned char)off_binary_magic[0]) {
+    ungetc(c, ifile);
+    return Status::ok();
   }
 
+  const size_t rest_len = strlen(off_binary_magic) - 1;
+  char rest[16];
+  if (fread(rest, 1, rest_len, ifile) != rest_len ||
+      memcmp(rest, off_binary_magic + 1, rest_len) != 0)
+    return Status::error("binary OFF: header: invalid magic number");
+
+  *is_binary = true;
   return Status::ok();
 }
 
 Status off_file_read(FILE *ifile, Geometry &geom)
 {
+  Status stat;
+  // standard input is read in binary mode, which also reads text OFF, as
+  // any carriage return is whitespace
+  off_binary_set_mode(ifile);
+  bool is_binary;
+  if (!(stat = check_binary_magic(ifile, &is_binary)))
+    return stat;
+  if (is_binary)
+    return off_binary_read(ifile, geom);
+
   int file_line_no = 0; // line number in the file
 
   // read OFF type
@@ -235,7 +449,8 @@ Status off_file_read(FILE *ifile, Geometry &geom)
   int data_line_no = 2; // non blank lines
 
   // Variables so that if all integer color values
-  // are 0 or 1, then they are all converted to decimals
+  // are 0 or 1, then they are all converted to decimals. Only the
+  // alternative colours that differ are stored.
   bool contains_int_gt_1 = false;
   Geometry alt_cols;
 
@@ -243,13 +458,21 @@ Status off_file_read(FILE *ifile, Geometry &geom)
   const unsigned int max_adj_equal_idx_lines = 6;
   vector<int> adj_equal_idx_lines;
 
-  // read coords
-  while (read_off_line(ifile, &line) == 0) {
+  // reserve element storage, limited as the counts have not been checked
+  // against the data
+  const int max_reserve = 1 << 22;
+  geom.raw_verts().reserve(std::min(num_pts, max_reserve));
+  geom.raw_faces().reserve(std::min(num_faces, max_reserve));
+
+  // read the elements, reusing the line buffer, parts and face storage
+  OffLineReader reader(ifile);
+  Split vals;
+  vector<int> face;
+  while (reader.get_line(&line) == 0) {
     file_line_no++;
 
-    Split vals(line);
-    if (!vals.size()) // line was blank
-      continue;       // skip the line
+    if (!vals.init(line)) // line was blank
+      continue;           // skip the line
 
     data_line_no++;
 
@@ -263,7 +486,7 @@ Status off_file_read(FILE *ifile, Geometry &geom)
     }
     else if (data_line_no <= 2 + num_pts + num_faces) { // face line
       bool contains_adj_equal_idx = false;
-      if (!(stat = add_face(geom, vals.get_parts(), alt_cols,
+      if (!(stat = add_face(geom, vals.get_parts(), face, alt_cols,
                             &contains_int_gt_1, &contains_adj_equal_idx))) {
         message = msg_str("line %d: ", file_line_no) + stat.msg();
         geom.clear_all();
@@ -279,13 +502,12 @@ Status off_file_read(FILE *ifile, Geometry &geom)
       geom.clear_all();
       break;
     }
-    free(line);
   }
 
-  free(line);
-
-  if (!contains_int_gt_1)
-    geom.get_cols() = alt_cols.get_cols();
+  if (!contains_int_gt_1) // use the alternative colours
+    for (int type : {VERTS, EDGES, FACES})
+      for (const auto &kp : alt_cols.colors(type))
+        geom.colors(type).set(kp.first, kp.second);
 
   // create warning message for adjacent equal vertex numbers on faces
   if (adj_equal_idx_lines.size()) {
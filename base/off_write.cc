@@ -41,12 +41,12 @@ using std::map;
 using std::string;
 using std::vector;
 
-FILE *file_open_w(string file_name, string &error_msg)
+FILE *file_open_w(string file_name, string &error_msg, bool binary = false)
 {
   error_msg.clear();
   FILE *ofile = stdout; // write to stdout by default
   if (file_name != "") {
-    ofile = fopen(file_name.c_str(), "w");
+    ofile = fopen(file_name.c_str(), binary ? "wb" : "w");
     if (!ofile)
       error_msg = "could not open file for writing '" + file_name +
                   "': " + strerror(errno);
@@ -60,11 +60,184 @@ void file_close_w(FILE *ofile)
     fclose(ofile);
 }
 
+// don't export these functions
+namespace {
+
+// Format output into a large reusable buffer, writing it to the file in
+// large chunks. The text is the same as with the equivalent fprintf calls.
+class WriteBuffer {
+private:
+  FILE *ofile;
+  vector<char> buf;
+  size_t pos = 0;
+  // formatted colour components, by component value (0 - 255)
+  vector<string> col_comps;
+
+public:
+  WriteBuffer(FILE *ofile) : ofile(ofile), buf(1 << 16) {}
+  ~WriteBuffer() { flush(); }
+
+  void flush()
+  {
+    if (pos)
+      fwrite(buf.data(), 1, pos, ofile);
+    pos = 0;
+  }
+
+  // make sure there is space for len more characters
+  void reserve(size_t len)
+  {
+    if (pos + len > buf.size()) {
+      flush();
+      if (len > buf.size())
+        buf.resize(len);
+    }
+  }
+
+  void add(char c)
+  {
+    reserve(1);
+    buf[pos++] = c;
+  }
+
+  void add(const char *str, size_t len)
+  {
+    reserve(len);
+    memcpy(buf.data() + pos, str, len);
+    pos += len;
+  }
+
+  void add(const char *str) { add(str, strlen(str)); }
+
+  // as "%d"
+  void add_int(int num)
+  {
+    char digits[12];
+    char *p = digits + sizeof(digits);
+    unsigned int u = (num < 0) ? 0u - (unsigned int)num : num;
+    do {
+      *--p = '0' + u % 10;
+      u /= 10;
+    } while (u);
+    if (num < 0)
+      *--p = '-';
+    add(p, digits + sizeof(digits) - p);
+  }
+
+  // as Vec3d::to_str()
+  void add_vec(const Vec3d &v, const char *sep, int sig_dgts)
+  {
+    if (!v.is_set()) {
+      add("not set");
+      return;
+    }
+    for (int i = 0; i < 3; i++) {
+      if (i)
+        add(sep);
+      add_double(v[i], sig_dgts);
+    }
+  }
+
+  // as "%.*g" for positive sig_dgts, otherwise "%.*f" with -sig_dgts
+  void add_double(double val, int sig_dgts)
+  {
+    while (true) {
+      const size_t space = buf.size() - pos;
+      int len = (sig_dgts > 0)
+                    ? snprintf(buf.data() + pos, space, "%.*g", sig_dgts, val)
+                    : snprintf(buf.data() + pos, space, "%.*f", -sig_dgts, val);
+      if (len < 0)
+        return;
+      if ((size_t)len < space) {
+        pos += len;
+        return;
+      }
+      reserve(len + 1);
+    }
+  }
+
+  // as the value returned by off_col()
+  void add_col(const Color &col)
+  {
+    if (col.is_index()) {
+      add(' ');
+      add_int(col.get_index());
+    }
+    else if (col.is_value()) {
+      const int num_comps = col.get_transparency() ? 4 : 3;
+      const Vec4d comps = col.get_vec4d();
+      for (int i = 0; i < num_comps; i++) {
+        if (i)
+          add(' ');
+        add_col_comp(col[i], comps[i]);
+      }
+    }
+  }
+
+  // a colour component, as "%.5f", only formatted once for each value
+  void add_col_comp(int comp, double val)
+  {
+    if (col_comps.empty())
+      col_comps.resize(256);
+    string &comp_str = col_comps[comp];
+    if (comp_str.empty())
+      comp_str = msg_str("%.5f", val);
+    add(comp_str.data(), comp_str.size());
+  }
+};
+
+void crds_write(WriteBuffer &out, const Geometry &geom, const char *sep,
+                int sig_dgts)
+{
+  for (const auto &v : geom.verts()) {
+    out.add_vec(v, sep, sig_dgts);
+    out.add('\n');
+  }
+}
+
+void off_polys_write(WriteBuffer &out, const Geometry &geom, int offset)
+{
+  const auto &f_cols = geom.colors(FACES);
+  for (unsigned int i = 0; i < geom.faces().size(); i++) {
+    const vector<int> &face = geom.faces(i);
+    out.add_int(face.size());
+    for (int v_idx : face) {
+      out.add(' ');
+      out.add_int(v_idx + offset);
+    }
+    out.add(' ');
+    out.add_col(f_cols.get(i));
+    out.add('\n');
+  }
+
+  const auto &e_cols = geom.colors(EDGES);
+  for (unsigned int i = 0; i < geom.edges().size(); i++) {
+    out.add("2 ", 2);
+    out.add_int(geom.edges(i, 0) + offset);
+    out.add(' ');
+    out.add_int(geom.edges(i, 1) + offset);
+    out.add(' ');
+    out.add_col(e_cols.get(i));
+    out.add('\n');
+  }
+
+  // print coloured vertex elements
+  for (const auto &kp : geom.colors(VERTS)) {
+    out.add("1 ", 2);
+    out.add_int(kp.first + offset);
+    out.add(' ');
+    out.add_col(kp.second);
+    out.add('\n');
+  }
+}
+
+} // namespace
+
 void crds_write(FILE *ofile, const Geometry &geom, const char *sep,
                 int sig_dgts)
 {
-  for (unsigned int i = 0; i < geom.verts().size(); i++)
-    fprintf(ofile, "%s\n", geom.verts(i).to_str(sep, sig_dgts).c_str());
+  WriteBuffer out(ofile);
+  crds_write(out, geom, sep, sig_dgts);
 }
 
 Status crds_write(string file_name, const Geometry &geom, const char *sep,
@@ -275,39 +448,23 @@ Status off_file_write(string file_name, const vector<const Geometry *> &geoms,
                       int sig_dgts)
 {
   string error_msg;
-  FILE *ofile = file_open_w(file_name, error_msg);
+  const bool binary = off_binary_output(file_name);
+  FILE *ofile = file_open_w(file_name, error_msg, binary);
   if (!ofile)
     return Status::error(error_msg);
 
-  off_file_write(ofile, geoms, sig_dgts);
+  if (binary)
+    off_binary_write(ofile, geoms);
+  else
+    off_file_write(ofile, geoms, sig_dgts);
   file_close_w(ofile);
   return Status::ok();
 }
 
 void off_polys_write(FILE *ofile, const Geometry &geom, int offset)
 {
-  for (unsigned int i = 0; i < geom.faces().size(); i++) {
-    fprintf(ofile, "%lu", (unsigned long)geom.faces(i).size());
-    for (unsigned int j = 0; j < geom.faces(i).size(); j++) {
-      fprintf(ofile, " %d", geom.faces(i, j) + offset);
-    }
-    fprintf(ofile, " %s", off_col(geom.colors(FACES).get(i)).c_str());
-    fprintf(ofile, "\n");
-  }
-
-  for (unsigned int i = 0; i < geom.edges().size(); i++) {
-    fprintf(ofile, "2 %d %d", geom.edges(i, 0) + offset,
-            geom.edges(i, 1) + offset);
-    fprintf(ofile, " %s", off_col(geom.colors(EDGES).get(i)).c_str());
-    fprintf(ofile, "\n");
-  }
-  // print coloured vertex elements
-  map<int, Color>::const_iterator mi;
-  for (mi = geom.colors(VERTS).get_properties().begin();
-       mi != geom.colors(VERTS).get_properties().end(); mi++) {
-    fprintf(ofile, "1 %d %s\n", (mi->first) + offset,
-            off_col(mi->second).c_str());
-  }
+  WriteBuffer out(ofile);
+  off_polys_write(out, geom, offset);
 }
 
 void off_file_write(FILE *ofile, const vector<const Geometry *> &geoms,
@@ -315,22 +472,26 @@ void off_file_write(FILE *ofile, const vector<const Geometry *> &geoms,
 {
   int vert_cnt = 0, face_cnt = 0, edge_cnt = 0;
   for (auto geom : geoms) {
-    int num_v_col_elems = geom->colors(VERTS).get_properties().size();
+    int num_v_col_elems = geom->colors(VERTS).size();
     vert_cnt += geom->verts().size();
     edge_cnt += geom->edges().size();
     face_cnt += geom->faces().size() + num_v_col_elems + edge_cnt;
   }
 
-  fprintf(ofile, "OFF\n%d %d 0\n", vert_cnt, face_cnt);
+  WriteBuffer out(ofile);
+  out.add("OFF\n");
+  out.add_int(vert_cnt);
+  out.add(' ');
+  out.add_int(face_cnt);
+  out.add(" 0\n");
 
   for (auto geom : geoms)
-    crds_write(ofile, *geom, " ", sig_dgts);
+    crds_write(out, *geom, " ", sig_dgts);
 
   int last_offset = 0;
   vert_cnt = 0;
   for (auto geom : geoms) {
-    off_polys_write(ofile, *geom,
-                    geom->verts().size() ? vert_cnt : last_offset);
+    off_polys_write(out, *geom, geom->verts().size() ? vert_cnt : last_offset);
     last_offset = vert_cnt;
     vert_cnt += geom->verts().size();
   }
@@ -29,7 +29,9 @@
 */
 
 #include "planar.h"
+#include "boundbox.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <map>
@@ -106,6 +108,19 @@ int vertex_into_geom(Geometry &geom, const Vec3d &P, Color vcol,
   return v_idx;
 }
 
+int vertex_into_geom(Geometry &geom, VertIndex &vert_idx, const Vec3d &P,
+                     Color vcol)
+{
+  int v_idx = vert_idx.find(P);
+  if (v_idx == -1) {
+    geom.add_vert(P, vcol);
+    v_idx = geom.verts().size() - 1;
+    vert_idx.update();
+  }
+
+  return v_idx;
+}
+
 // if edge already exists, do not create another one and return false. return
 // true if new edge created
 // check if edge1 and edge2 indexes are equal. If so do not allow an edge length
@@ -126,6 +141,78 @@ bool edge_into_geom(Geometry &geom, const int v_idx1, const int v_idx2,
   return ((answer < 0) ? true : false);
 }
 
+// add an edge as edge_into_geom(), but check for an existing edge in a set
+// of edges (with vertex index numbers in order) which is updated
+static bool edge_into_geom(Geometry &geom, set<pair<int, int>> &edge_set,
+                           const int v_idx1, const int v_idx2, Color ecol)
+{
+  // no edge length 0 allowed
+  if (v_idx1 == v_idx2)
+    return false;
+
+  vector<int> new_edge = make_edge(v_idx1, v_idx2);
+  bool is_new = edge_set.insert(make_pair(new_edge[0], new_edge[1])).second;
+  if (is_new)
+    geom.add_edge(new_edge, ecol);
+
+  return is_new;
+}
+
+// find, for each edge, the other edges that might intersect it, because
+// their bounding boxes, extended by margin, overlap. The lists are in
+// index order. The boxes are swept along the axis of greatest extent.
+static vector<vector<int>> get_overlapping_edges(const Geometry &geom,
+                                                 double margin)
+{
+  const vector<Vec3d> &verts = geom.verts();
+  const vector<vector<int>> &edges = geom.edges();
+  const int esz = edges.size();
+
+  vector<Vec3d> mins(esz);
+  vector<Vec3d> maxs(esz);
+  for (int i = 0; i < esz; i++) {
+    const Vec3d &v0 = verts[edges[i][0]];
+    const Vec3d &v1 = verts[edges[i][1]];
+    for (int k = 0; k < 3; k++) {
+      mins[i][k] = std::min(v0[k], v1[k]) - margin;
+      maxs[i][k] = std::max(v0[k], v1[k]) + margin;
+    }
+  }
+
+  BoundBox bb(verts);
+  const Vec3d extent = bb.get_max() - bb.get_min();
+  int ax = 0;
+  for (int k = 1; k < 3; k++)
+    if (extent[k] > extent[ax])
+      ax = k;
+
+  vector<int> order(esz);
+  for (int i = 0; i < esz; i++)
+    order[i] = i;
+  sort(order.begin(), order.end(),
+       [&](int i, int j) { return mins[i][ax] < mins[j][ax]; });
+
+  vector<vector<int>> overlaps(esz);
+  for (int k = 0; k < esz; k++) {
+    const int i = order[k];
+    for (int m = k + 1; m < esz && mins[order[m]][ax] <= maxs[i][ax]; m++) {
+      const int j = order[m];
+      bool overlap = true;
+      for (int c = 0; c < 3 && overlap; c++)
+        overlap = (mins[i][c] <= maxs[j][c] && mins[j][c] <= maxs[i][c]);
+      if (overlap) {
+        overlaps[i].push_back(j);
+        overlaps[j].push_back(i);
+      }
+    }
+  }
+
+  for (auto &overlap : overlaps)
+    sort(overlap.begin(), overlap.end());
+
+  return overlaps;
+}
+
 // input seperate networks of overlapping edges and merge them into one network
 bool mesh_edges(Geometry &geom, const double eps)
 {
@@ -139,29 +226,36 @@ bool mesh_edges(Geometry &geom, const double eps)
   double mesh_radius = info.vert_dist_lims().max;
   geom.transform(Trans3d::scale(1 / mesh_radius));
 
+  // index the vertices for coordinate lookup, new vertices are only appended
+  VertIndex vert_idx(geom, eps);
+
+  // only edges with overlapping bounding boxes can intersect, the margin
+  // includes the tolerance for the intersection to lie beyond an edge end
+  const vector<vector<int>> overlaps = get_overlapping_edges(geom, 4 * eps);
+
+  // existing edges, with vertex index numbers in order
+  set<pair<int, int>> edge_set;
+  for (const auto &edge : edges) {
+    vector<int> ord_edge = make_edge(edge[0], edge[1]);
+    edge_set.insert(make_pair(ord_edge[0], ord_edge[1]));
+  }
+
   // remember original sizes as the geom will be changing size
   unsigned int vsz = verts.size();
   unsigned int esz = edges.size();
 
   vector<int> deleted_edges;
-  vector<pair<pair<int, int>, int>> new_verts;
+  map<pair<int, int>, int> new_verts;
 
   // compare only existing edges
   for (unsigned int i = 0; i < esz; i++) {
     vector<pair<double, int>> line_intersections;
-    for (unsigned int j = 0; j < esz; j++) {
-      // don't compare to self
-      if (i == j)
-        continue;
-
+    for (int j : overlaps[i]) {
       // see if the new vertex was already created
       int v_idx = -1;
-      for (auto &new_vert : new_verts) {
-        if (new_vert.first.first == (int)i && new_vert.first.second == (int)j) {
-          v_idx = new_vert.second;
-          break;
-        }
-      }
+      auto new_vert = new_verts.find(make_pair((int)i, j));
+      if (new_vert != new_verts.end())
+        v_idx = new_vert->second;
 
       // if it doesn't already exist, see if it needs to be created
       if (v_idx == -1) {
@@ -171,19 +265,15 @@ bool mesh_edges(Geometry &geom, const double eps)
                                   verts[edges[j][0]], verts[edges[j][1]], eps);
         if (intersection_point.is_set()) {
           // find (or create) index of this vertex
-          v_idx =
-              vertex_into_geom(geom, intersection_point, Color::invisible, eps);
+          v_idx = vertex_into_geom(geom, vert_idx, intersection_point,
+                                   Color::invisible);
           // don't include existing vertices
           if (v_idx < (int)vsz)
             v_idx = -1;
           else {
             // store index of vert at i,j. Reverse index i,j so it will be found
             // when encountering edges j,i
-            pair<pair<int, int>, int> new_vert;
-            new_vert.first.first = j;
-            new_vert.first.second = i;
-            new_vert.second = v_idx;
-            new_verts.push_back(new_vert);
+            new_verts[make_pair(j, (int)i)] = v_idx;
           }
         }
       }
@@ -203,12 +293,12 @@ bool mesh_edges(Geometry &geom, const double eps)
       sort(line_intersections.begin(), line_intersections.end());
       // create edgelets from P0 through intersection points to P1 (using
       // indexes)
-      edge_into_geom(geom, edges[i][0], line_intersections[0].second,
-                     Color::invisible);
+      edge_into_geom(geom, edge_set, edges[i][0],
+                     line_intersections[0].second, Color::invisible);
       for (unsigned int k = 0; k < line_intersections.size() - 1; k++)
-        edge_into_geom(geom, line_intersections[k].second,
+        edge_into_geom(geom, edge_set, line_intersections[k].second,
                        line_intersections[k + 1].second, Color::invisible);
-      edge_into_geom(geom,
+      edge_into_geom(geom, edge_set,
                      line_intersections[line_intersections.size() - 1].second,
                      edges[i][1], Color::invisible);
     }
@@ -35,6 +35,7 @@
 #include "geometryinfo.h"
 #include "geometryutils.h"
 #include "vec3d.h"
+#include "vertindex.h"
 
 using std::map;
 using std::string;
@@ -59,6 +60,16 @@ Geometry faces_to_geom(const Geometry &geom, const std::vector<int> &face_idxs);
 int vertex_into_geom(Geometry &geom, const Vec3d &P, Color vcol,
                      const double eps);
 
+/// add a vector P into the geom unless a point already occupies that point
+/**\param geom the geometry.
+ * \param vert_idx an index of the geometry vertices, which sets the limit
+ *  of precision, and is updated with a new point.
+ * \param P a point.
+ * \param vcol color of the new point.
+ * \return the index of the new point, or the occupying point. */
+int vertex_into_geom(Geometry &geom, VertIndex &vert_idx, const Vec3d &P,
+                     Color vcol);
+
 /// add an edge v1, v2 into the geom unless an edge of v1, v2 already exists
 /**\param geom the geometry.
  * \param v_idx1 is the first index.
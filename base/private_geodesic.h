@@ -34,7 +34,7 @@
 #include "geometry.h"
 #include "geometryutils.h"
 
-#include <map>
+#include <array>
 #include <string>
 #include <vector>
 
@@ -76,60 +76,78 @@ private:
   char method;
   anti::Vec3d centre;
 
-  std::map<std::vector<int>, int> edge_idx;
-  std::map<std::vector<int>, std::vector<int>> edge_faces;
-  // std::map<std::vector<int>, int> face_idx;
-  std::map<int_pr, int> grid_idxs;
+  // Edges of each vertex to higher index vertices, as (vertex, edge index)
+  // pairs, stored consecutively from vert_edge_starts[vertex]
+  std::vector<int> vert_edge_starts;
+  std::vector<int_pr> vert_edges;
+  // Faces on each side of an edge, the first where it runs from its lower
+  // index vertex, or -1 for no face
+  std::vector<std::array<int, 2>> edge_faces;
+  std::vector<std::vector<int>> face_indxs; // index vectors of faces
+  std::vector<int> edge_owners; // face that sets the points of an edge
+  std::vector<int> grid_idxs;   // face point index for grid i,j or noindex
+  int grid_sz;                  // grid_idxs holds grid_sz x grid_sz points
+  int num_threads;
 
   void init();
   void sphere_projection(anti::Geometry &geom);
+  void make_edge_tables();
   void make_grid_idxs();
-  int grid_x(int i, int j) { return i * (-m) + j * (m + n); }
-  int grid_y(int i, int j) { return i * (m + n) + j * (-n); }
-  int_pr rot_e0(int_pr crds) // half-rot about centre e0
+  int grid_x(int i, int j) const { return i * (-m) + j * (m + n); }
+  int grid_y(int i, int j) const { return i * (m + n) + j * (-n); }
+  int_pr rot_e0(int_pr crds) const // half-rot about centre e0
   {
     return mk_int_pr(freq - crds.first, -crds.second);
   }
-  int_pr rot_f(int_pr crds) // third-rot about centre f
+  int_pr rot_f(int_pr crds) const // third-rot about centre f
   {
     return mk_int_pr(freq - crds.first - crds.second, crds.first);
   }
-  int_pr normal_crds(int_pr crds);
+  int_pr normal_crds(int_pr crds) const;
 
-  int coord_i(int_pr crds)
+  int coord_i(int_pr crds) const
   {
     return (n * crds.first + (m + n) * crds.second) / (m * m + m * n + n * n);
   }
-  int coord_j(int_pr crds)
+  int coord_j(int_pr crds) const
   {
     return ((m + n) * crds.first + m * crds.second) / (m * m + m * n + n * n);
   }
 
-  void grid_to_points(std::vector<int> indx, std::vector<anti::Vec3d> &gverts);
-  bool tri_test(int i, int j, int di, int dj);
-  void grid_to_tris(std::vector<int> indx,
+  // The const methods below are called from several threads at once while
+  // the faces are filled, so they must only read the members
+  void grid_to_points(const std::vector<int> &indx,
+                      std::vector<anti::Vec3d> &gverts) const;
+  bool tri_test(int i, int j, int di, int dj) const;
+  void grid_to_tris(const std::vector<int> &indx,
                     std::vector<std::vector<int>> &new_tris,
-                    std::vector<std::vector<int>> &orig_edges);
+                    std::vector<std::vector<int>> &orig_edges) const;
   std::vector<int> make_face_indexes(int i, const std::vector<int> &face);
   int index_map(int i, int j, const std::vector<int> &indx,
-                int p_idx = noindex);
+                int p_idx = noindex) const;
 
   int get_edge_index(int v0, int v1);
   std::vector<int> get_face_indexes(std::vector<int> face);
 
-  IJPos get_pos_xy(int x, int y)
+  IJPos get_pos_xy(int x, int y) const
   {
     if (x < 0 || y < 0 || x + y > freq)
       return IJPos::out;
     else
       return IJPos((x == 0) + 2 * (y == 0) + 4 * (x + y == freq));
   }
-  IJPos get_pos(int i, int j) { return get_pos_xy(grid_x(i, j), grid_y(i, j)); }
+  IJPos get_pos(int i, int j) const
+  {
+    return get_pos_xy(grid_x(i, j), grid_y(i, j));
+  }
 
 public:
   enum { err_not_tri = 1 };
   Geodesic(const anti::Geometry &base_poly, int mm, int nn = 0, char mthd = 's',
            anti::Vec3d cen = anti::Vec3d(0, 0, 0));
+  // Set the number of threads used to fill the base faces, 0 for the
+  // number of processors
+  void set_num_threads(int num) { num_threads = num; }
   void make_geo(anti::Geometry &geo);
 };
 
@@ -52,6 +52,13 @@ void obj_write(FILE *ofile, FILE *mfile, std::string mtl_file,
                const Geometry &geom, const char *sep = " ",
                int sig_dgts = DEF_SIG_DGTS);
 
+extern const char off_binary_magic[];
+bool off_binary_output(const std::string &file_name);
+void off_binary_set_mode(FILE *file);
+anti::Status off_binary_read(FILE *ifile, anti::Geometry &geom);
+void off_binary_write(FILE *ofile,
+                      const std::vector<const anti::Geometry *> &geoms);
+
 anti::Status off_file_read(std::string file_name, anti::Geometry &geom);
 anti::Status off_file_read(FILE *ifile, anti::Geometry &geom);
 
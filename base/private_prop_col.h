@@ -58,7 +58,10 @@ For more information on this code, see Anuj Mehrotra and Michael A. Trick,
 
 class ProperColor {
 private:
-  std::set<std::pair<int, int>> adj;
+  std::vector<std::pair<int, int>> adj_prs; // adjacent pairs, as set
+  std::set<std::pair<int, int>> adj;        // adjacent pairs, exact search
+  std::vector<int> nbr_starts;              // adjacency in compressed sparse
+  std::vector<int> nbrs;                    // row format, for DSATUR
   int BestColoring;
   std::vector<int> ColorClass;
   std::vector<int> BestColorClass;
@@ -82,6 +85,16 @@ private:
   void assign_color(int node, int color);
   void remove_color(int node, int color);
   int color(int i, int current_color);
+  void make_nbrs();
+  int find_sat(int node, const std::vector<int> &cols,
+               std::vector<int> &seen, int &stamp);
+  bool move_node(int node, std::vector<int> &cols,
+                 std::vector<char> &on_path, int num_cols, int depth,
+                 int &steps, std::vector<int> &changed);
+  bool free_color(int node, std::vector<int> &cols,
+                  std::vector<char> &on_path, int num_cols, int *freed_col,
+                  std::vector<int> &changed);
+  void dsatur_colors();
   bool is_adj(int i, int j)
   {
     if (i > j)
@@ -91,13 +104,21 @@ private:
   void set_color(int i, int col) { BestColorClass[i] = col + 1; }
 
 public:
+  /// Largest graph coloured with the exact search, larger graphs are
+  /// coloured with DSATUR using sparse adjacency lists
+  enum { max_exact_nodes = 2000 };
+
+  /// Limits on the search to free a colour before DSATUR adds a colour,
+  /// the length of a chain of moved nodes, and the nodes tried in total
+  enum { max_recolor_depth = 8, max_recolor_steps = 200 };
+
   ProperColor(int nodes, int max_visits = 100)
       : max_num_visits(max_visits), num_node(nodes){};
   void set_adj(int i, int j)
   {
     if (i > j)
       std::swap(i, j);
-    adj.insert(std::make_pair(i, j));
+    adj_prs.push_back(std::make_pair(i, j));
   }
   int find_colors();
   int get_color(int i) { return BestColorClass[i] - 1; }
@@ -48,10 +48,12 @@ For more information on this code, see Anuj Mehrotra and Michael A. Trick,
 
 #include "private_prop_col.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <set>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -59,8 +61,204 @@ using std::pair;
 using std::set;
 using std::vector;
 
+void ProperColor::make_nbrs()
+{
+  nbr_starts.assign(num_node + 1, 0);
+  for (const auto &pr : adj_prs)
+    if (pr.first != pr.second) {
+      nbr_starts[pr.first + 1]++;
+      nbr_starts[pr.second + 1]++;
+    }
+  for (int i = 0; i < num_node; i++)
+    nbr_starts[i + 1] += nbr_starts[i];
+
+  nbrs.resize(nbr_starts.back());
+  vector<int> pos(nbr_starts.begin(), nbr_starts.end() - 1);
+  for (const auto &pr : adj_prs)
+    if (pr.first != pr.second) {
+      nbrs[pos[pr.first]++] = pr.second;
+      nbrs[pos[pr.second]++] = pr.first;
+    }
+}
+
+// Number of different colours on the neighbours of a node
+int ProperColor::find_sat(int node, const vector<int> &cols,
+                          vector<int> &seen, int &stamp)
+{
+  stamp++;
+  int sat = 0;
+  for (int n = nbr_starts[node]; n < nbr_starts[node + 1]; n++) {
+    const int col = cols[nbrs[n]];
+    if (col >= 0 && seen[col] != stamp) {
+      seen[col] = stamp;
+      sat++;
+    }
+  }
+  return sat;
+}
+
+// Change a node to another existing colour. If a colour is used by only
+// one neighbour then that neighbour may itself be moved, and so on, to a
+// limited depth and number of steps. Nodes on the current chain are not
+// moved again. On failure the colours are left unchanged, on success the
+// moved nodes are added to changed.
+bool ProperColor::move_node(int node, vector<int> &cols,
+                            vector<char> &on_path, int num_cols, int depth,
+                            int &steps, vector<int> &changed)
+{
+  if (steps-- <= 0)
+    return false;
+
+  // number of neighbours with each colour, and one of those neighbours
+  vector<int> cnts(num_cols, 0);
+  vector<int> col_nbr(num_cols, -1);
+  for (int n = nbr_starts[node]; n < nbr_starts[node + 1]; n++) {
+    const int col = cols[nbrs[n]];
+    if (col >= 0) {
+      cnts[col]++;
+      col_nbr[col] = nbrs[n];
+    }
+  }
+
+  const int old_col = cols[node];
+  for (int col = 0; col < num_cols; col++)
+    if (col != old_col && cnts[col] == 0) {
+      cols[node] = col;
+      changed.push_back(node);
+      return true;
+    }
+
+  if (depth == 0)
+    return false;
+
+  on_path[node] = true;
+  for (int col = 0; col < num_cols && steps > 0; col++) {
+    const int nbr = col_nbr[col];
+    if (col == old_col || cnts[col] != 1 || on_path[nbr])
+      continue;
+    cols[node] = col;
+    if (move_node(nbr, cols, on_path, num_cols, depth - 1, steps, changed)) {
+      on_path[node] = false;
+      changed.push_back(node);
+      return true;
+    }
+    cols[node] = old_col;
+  }
+  on_path[node] = false;
+  return false;
+}
+
+// An uncoloured node has a neighbour of every colour. Look for a colour
+// used by only one neighbour, where that neighbour can be moved with
+// move_node(), to free the colour for the node.
+bool ProperColor::free_color(int node, vector<int> &cols,
+                             vector<char> &on_path, int num_cols,
+                             int *freed_col, vector<int> &changed)
+{
+  vector<int> cnts(num_cols, 0);
+  vector<int> col_nbr(num_cols, -1);
+  for (int n = nbr_starts[node]; n < nbr_starts[node + 1]; n++) {
+    const int col = cols[nbrs[n]];
+    if (col >= 0) {
+      cnts[col]++;
+      col_nbr[col] = nbrs[n];
+    }
+  }
+
+  int steps = max_recolor_steps;
+  on_path[node] = true;
+  for (int col = 0; col < num_cols && steps > 0; col++) {
+    if (cnts[col] != 1)
+      continue;
+    cols[node] = col; // the moved nodes must not take this colour
+    if (move_node(col_nbr[col], cols, on_path, num_cols,
+                  max_recolor_depth - 1, steps, changed)) {
+      *freed_col = col;
+      break;
+    }
+  }
+  on_path[node] = false;
+  cols[node] = -1;
+  return !changed.empty();
+}
+
+// DSATUR: colour the node with the most differently coloured neighbours
+// next, choosing the lowest colour not used by a neighbour, and before
+// adding a colour try moving neighbours to other colours to free one
+void ProperColor::dsatur_colors()
+{
+  make_nbrs();
+  vector<pair<int, int>>().swap(adj_prs); // free the memory
+
+  vector<int> cols(num_node, -1);
+  vector<int> sat(num_node, 0);   // saturation, number of neighbour colours
+  vector<int> u_deg(num_node, 0); // number of uncoloured neighbours
+  vector<int> seen(num_node + 1, 0);
+  int stamp = 0;
+  vector<char> on_path(num_node, false); // nodes on a recolouring chain
+  vector<int> changed;                   // nodes moved to free a colour
+
+  // uncoloured nodes, first is highest saturation, then degree, then lowest
+  // index number
+  set<std::tuple<int, int, int>> queue;
+  for (int i = 0; i < num_node; i++) {
+    u_deg[i] = nbr_starts[i + 1] - nbr_starts[i];
+    queue.insert(std::make_tuple(0, -u_deg[i], i));
+  }
+
+  auto requeue = [&](int node, int deg_chg) {
+    queue.erase(std::make_tuple(-sat[node], -u_deg[node], node));
+    sat[node] = find_sat(node, cols, seen, stamp);
+    u_deg[node] += deg_chg;
+    queue.insert(std::make_tuple(-sat[node], -u_deg[node], node));
+  };
+
+  int num_cols = 0;
+  while (!queue.empty()) {
+    const int node = std::get<2>(*queue.begin());
+    queue.erase(queue.begin());
+
+    stamp++;
+    for (int n = nbr_starts[node]; n < nbr_starts[node + 1]; n++)
+      if (cols[nbrs[n]] >= 0)
+        seen[cols[nbrs[n]]] = stamp;
+    int col = 0;
+    while (col < num_cols && seen[col] == stamp)
+      col++;
+
+    if (col == num_cols) {
+      changed.clear();
+      if (free_color(node, cols, on_path, num_cols, &col, changed)) {
+        for (int moved : changed)
+          for (int n = nbr_starts[moved]; n < nbr_starts[moved + 1]; n++)
+            if (cols[nbrs[n]] < 0 && nbrs[n] != node)
+              requeue(nbrs[n], 0);
+      }
+      else
+        num_cols++;
+    }
+
+    cols[node] = col;
+    for (int n = nbr_starts[node]; n < nbr_starts[node + 1]; n++)
+      if (cols[nbrs[n]] < 0)
+        requeue(nbrs[n], -1);
+  }
+
+  BestColorClass.resize(num_node);
+  for (int i = 0; i < num_node; i++)
+    BestColorClass[i] = cols[i] + 1;
+}
+
 int ProperColor::find_colors()
 {
+  std::sort(adj_prs.begin(), adj_prs.end());
+  adj_prs.erase(std::unique(adj_prs.begin(), adj_prs.end()), adj_prs.end());
+  if (num_node > max_exact_nodes) {
+    dsatur_colors();
+    return 0;
+  }
+  adj.insert(adj_prs.begin(), adj_prs.end());
+
   prob_count = 0;
   visit_cnt.resize(num_node + 1, 0);
   ColorAdj.resize(num_node, vector<int>(num_node + 1, 0));
@@ -77,15 +275,13 @@ int ProperColor::find_colors()
   Order.resize(num_node, 0);
   BestColoring = num_node + 1;
 
-  int valid[num_node], clique[num_node];
-  for (int i = 0; i < num_node; i++)
-    valid[i] = true;
+  vector<int> valid(num_node, true), clique(num_node);
 
   best_clique = 0;
   num_prob = 0;
   max_prob = 10000;
 
-  lb = max_w_clique(valid, clique, 0, num_node);
+  lb = max_w_clique(valid.data(), clique.data(), 0, num_node);
 
   int place = 0;
 
@@ -275,9 +471,7 @@ int ProperColor::max_w_clique(int *valid, int *clique, int lower, int target)
     if (clique[j])
       continue;
 
-    int valid1[num_node];
-    for (int place1 = 0; place1 < num_node; place1++)
-      valid1[place1] = false;
+    vector<int> valid1(num_node, false);
     for (int place1 = 0; place1 < place; place1++) {
       int k = order[place1];
       if (valid[k] && is_adj(j, k))
@@ -285,8 +479,9 @@ int ProperColor::max_w_clique(int *valid, int *clique, int lower, int target)
       else
         valid1[k] = false;
     }
-    int clique1[num_node];
-    int new_weight = max_w_clique(valid1, clique1, incumb - 1, target - 1);
+    vector<int> clique1(num_node);
+    int new_weight =
+        max_w_clique(valid1.data(), clique1.data(), incumb - 1, target - 1);
     if (new_weight + 1 > incumb) {
       /*      printf("Taking new\n");*/
       incumb = new_weight + 1;
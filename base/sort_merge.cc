@@ -34,12 +34,16 @@
 #include "geometryinfo.h"
 #include "geometryutils.h"
 #include "mathutils.h"
+#include "vertindex.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <map>
+#include <numeric>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 using std::map;
@@ -82,11 +86,6 @@ public:
   vertexMap(int o, int n) : old_vertex(o), new_vertex(n) {}
 };
 
-bool cmp_vertexMap(const vertexMap &a, const vertexMap &b)
-{
-  return a.old_vertex < b.old_vertex;
-}
-
 void remap_faces(vector<vector<int>> &faces, const vector<vertexMap> &vm)
 {
   for (auto &face : faces)
@@ -343,19 +342,151 @@ bool cmp_vert_no(const vertSortPostMerge &a, const vertSortPostMerge &b)
   return a.vert_no < b.vert_no;
 }
 
-Color average_vert_color(const vector<vertSort> &vs, const int begin,
-                         const int end, const int blend_type)
+// Find the sets of vertices joined by coincidences, returning the index
+// of a set for each vertex
+vector<int> find_coincident_vert_groups(const vector<Vec3d> &verts, double eps)
 {
-  // quick decision, if only one instance, return its own color
-  if (!(end - begin))
-    return vs[begin].col;
+  // union-find, with the lowest vertex index number as the root
+  vector<int> parent(verts.size());
+  std::iota(parent.begin(), parent.end(), 0);
+  auto find_root = [&](int v) {
+    while (parent[v] != v) {
+      parent[v] = parent[parent[v]];
+      v = parent[v];
+    }
+    return v;
+  };
+  auto join = [&](int v0, int v1) {
+    int root0 = find_root(v0);
+    int root1 = find_root(v1);
+    if (root0 != root1)
+      parent[std::max(root0, root1)] = std::min(root0, root1);
+  };
+
+  // The vertices are put in grid cells half eps wide, so the vertices in
+  // a cell are coincident with the first vertex in the cell, and are
+  // joined to it without testing them against each other. A large cluster
+  // of coincident vertices is then not quadratic. A vertex that fails the
+  // test, which only happens far from the origin, where the cell
+  // coordinates are clamped, is tested against all the nearby vertices.
+  const double cell_sz = (eps > 0) ? eps / 2 : 1.0;
+  const double max_cell_coord = 1e17;
+  auto get_cell = [&](const Vec3d &v) {
+    long long c[3];
+    for (int i = 0; i < 3; i++) {
+      double coord = floor(v[i] / cell_sz);
+      c[i] = (long long)std::max(-max_cell_coord,
+                                 std::min(max_cell_coord, coord));
+    }
+    return VertIndex::Cell{c[0], c[1], c[2]};
+  };
+  auto cell_less = [](const VertIndex::Cell &c0, const VertIndex::Cell &c1) {
+    if (c0.x != c1.x)
+      return c0.x < c1.x;
+    if (c0.y != c1.y)
+      return c0.y < c1.y;
+    return c0.z < c1.z;
+  };
+
+  // sort the vertices by cell, and join all the unset vertices
+  vector<std::pair<VertIndex::Cell, int>> cell_verts;
+  int first_unset = -1;
+  for (unsigned int i = 0; i < verts.size(); i++) {
+    if (verts[i].is_set())
+      cell_verts.push_back(std::make_pair(get_cell(verts[i]), i));
+    else if (first_unset < 0)
+      first_unset = i;
+    else
+      join(first_unset, i);
+  }
+  std::sort(cell_verts.begin(), cell_verts.end(),
+            [&](const std::pair<VertIndex::Cell, int> &cv0,
+                const std::pair<VertIndex::Cell, int> &cv1) {
+              return cell_less(cv0.first, cv1.first) ||
+                     (cv0.first == cv1.first && cv0.second < cv1.second);
+            });
+
+  // join the vertices of each cell to the first vertex in the cell,
+  // and mark any that are not coincident with it
+  vector<int> cell_starts; // start of each cell in cell_verts, and the end
+  std::unordered_map<VertIndex::Cell, int, VertIndex::CellHash> cell_nums;
+  vector<bool> odd(cell_verts.size(), false);
+  vector<int> odd_verts;
+  for (unsigned int i = 0; i < cell_verts.size(); i++) {
+    if (i == 0 || !(cell_verts[i].first == cell_verts[i - 1].first)) {
+      cell_nums[cell_verts[i].first] = cell_starts.size();
+      cell_starts.push_back(i);
+      continue;
+    }
+    const int v_idx = cell_verts[i].second;
+    const int head = cell_verts[cell_starts.back()].second;
+    if (!compare(verts[v_idx], verts[head], eps))
+      join(v_idx, head);
+    else {
+      odd[i] = true;
+      odd_verts.push_back(i);
+    }
+  }
+  cell_starts.push_back(cell_verts.size());
+
+  // Coincident vertices are at most two cells apart. The vertices joined
+  // to the first vertex of a cell are all in one set, so a pair of cells
+  // is joined on the first coincidence found between them.
+  const int num_cells = cell_starts.size() - 1;
+  for (int c0 = 0; c0 < num_cells; c0++) {
+    const VertIndex::Cell &cell = cell_verts[cell_starts[c0]].first;
+    for (int i = -2; i < 3; i++)
+      for (int j = -2; j < 3; j++)
+        for (int k = -2; k < 3; k++) {
+          // visit each pair of cells once
+          const VertIndex::Cell nbr = {cell.x + i, cell.y + j, cell.z + k};
+          if (!cell_less(cell, nbr))
+            continue;
+          const auto it = cell_nums.find(nbr);
+          if (it == cell_nums.end())
+            continue;
+          const int c1 = it->second;
+          if (find_root(cell_verts[cell_starts[c0]].second) ==
+              find_root(cell_verts[cell_starts[c1]].second))
+            continue;
+          bool joined = false;
+          for (int p0 = cell_starts[c0]; p0 < cell_starts[c0 + 1] && !joined;
+               p0++) {
+            if (odd[p0])
+              continue;
+            for (int p1 = cell_starts[c1]; p1 < cell_starts[c1 + 1]; p1++) {
+              if (!odd[p1] && !compare(verts[cell_verts[p0].second],
+                                       verts[cell_verts[p1].second], eps)) {
+                join(cell_verts[p0].second, cell_verts[p1].second);
+                joined = true;
+                break;
+              }
+            }
+          }
+        }
+  }
 
-  // collect colors
-  vector<Color> cols;
-  for (int i = begin; i <= end; i++)
-    cols.push_back(vs[i].col);
+  // test the odd vertices against every vertex nearby
+  for (int p0 : odd_verts) {
+    const int v_idx = cell_verts[p0].second;
+    const VertIndex::Cell &cell = cell_verts[p0].first;
+    for (int i = -2; i < 3; i++)
+      for (int j = -2; j < 3; j++)
+        for (int k = -2; k < 3; k++) {
+          const auto it =
+              cell_nums.find({cell.x + i, cell.y + j, cell.z + k});
+          if (it == cell_nums.end())
+            continue;
+          const int c1 = it->second;
+          for (int p1 = cell_starts[c1]; p1 < cell_starts[c1 + 1]; p1++)
+            if (!compare(verts[v_idx], verts[cell_verts[p1].second], eps))
+              join(v_idx, cell_verts[p1].second);
+        }
+  }
 
-  return (cols.size() ? average_color(cols, blend_type) : Color());
+  for (unsigned int i = 0; i < verts.size(); i++)
+    parent[i] = find_root(i);
+  return parent;
 }
 
 // both a vertex map of all vertices AND a vertex map of merged vertices are
@@ -391,6 +522,9 @@ void sort_vertices(Geometry &geom, vector<vertexMap> &vm_all_verts,
     vs.push_back(vertSort(i, verts[i], col));
   }
 
+  // sets of coincident vertices
+  vector<int> grp_of_vert = find_coincident_vert_groups(verts, eps);
+
   // clear some memory
   geom.clear(VERTS);
 
@@ -401,49 +535,68 @@ void sort_vertices(Geometry &geom, vector<vertexMap> &vm_all_verts,
   // vertices
   if (!merge_verts) {
     for (unsigned int i = 0; i < vs.size(); i++)
-      vm_all_verts.push_back(vertexMap(vs[i].vert_no, i));
-    stable_sort(vm_all_verts.begin(), vm_all_verts.end(), cmp_vertexMap);
+      vm_all_verts.push_back(vertexMap(i, -1));
+    for (unsigned int i = 0; i < vs.size(); i++)
+      vm_all_verts[vs[i].vert_no].new_vertex = i;
   }
 
   // if merging vertices, build map for merged vertices
   // mark coincident vertices for skipping if any
   // this is always done
+  // coincident vertices are found with a spatial index, and a set of
+  // vertices joined by coincidences is numbered, and takes its colour,
+  // in the sorted order of its first vertex, even if it is not a single
+  // run in the sort
+  vector<int> sort_grps(vs.size()); // group number of sorted verts
   if (true) {
-    int v = 0;
-    int cur_undeleted = 0; // the first face in a set of equivalent verts
-    unsigned int j = 0;
-    for (unsigned int i = 0; i < vs.size() - 1; i++) {
-      j = i + 1;
-
-      vm_merged_verts.push_back(vertexMap(vs[i].vert_no, v));
+    vector<int> grp_nums(vs.size(), -1); // group index -> number
+    for (unsigned int i = 0; i < vs.size(); i++)
+      vm_merged_verts.push_back(vertexMap(i, -1));
+    int num_grps = 0;
+    for (unsigned int i = 0; i < vs.size(); i++) {
+      int &grp_num = grp_nums[grp_of_vert[vs[i].vert_no]];
+      if (grp_num < 0)
+        grp_num = num_grps++;
+      else if (merge_verts) // don't set delete flag if we will not use it
+        vs[i].deleted = true;
+      sort_grps[i] = grp_num;
+      vm_merged_verts[vs[i].vert_no].new_vertex = grp_num;
+    }
 
-      if (!compare(vs[i].vert, vs[j].vert, eps)) {
-        // don't set delete flag if we will not be using it
-        if (merge_verts)
-          vs[j].deleted = true;
-      }
-      else {
-        v++;
-        if (include_colors)
-          vs[cur_undeleted].average_col =
-              average_vert_color(vs, cur_undeleted, i, blend_type);
-        cur_undeleted = j;
+    if (include_colors) {
+      // sorted positions of the vertices of each group
+      vector<int> grp_starts(num_grps + 1, 0);
+      for (int grp : sort_grps)
+        grp_starts[grp + 1]++;
+      for (int i = 0; i < num_grps; i++)
+        grp_starts[i + 1] += grp_starts[i];
+      vector<int> grp_verts(vs.size());
+      vector<int> pos(grp_starts.begin(), grp_starts.end() - 1);
+      for (unsigned int i = 0; i < vs.size(); i++)
+        grp_verts[pos[sort_grps[i]]++] = i;
+
+      vector<Color> cols;
+      for (int grp = 0; grp < num_grps; grp++) {
+        const int first = grp_verts[grp_starts[grp]];
+        if (grp_starts[grp + 1] - grp_starts[grp] == 1) {
+          // quick decision, if only one instance, use its own color
+          vs[first].average_col = vs[first].col;
+          continue;
+        }
+        cols.clear();
+        for (int i = grp_starts[grp]; i < grp_starts[grp + 1]; i++)
+          cols.push_back(vs[grp_verts[i]].col);
+        vs[first].average_col = average_color(cols, blend_type);
       }
     }
-    if (include_colors)
-      vs[cur_undeleted].average_col =
-          average_vert_color(vs, cur_undeleted, j, blend_type);
-
-    vm_merged_verts.push_back(vertexMap(vs.back().vert_no, v));
-
-    stable_sort(vm_merged_verts.begin(), vm_merged_verts.end(), cmp_vertexMap);
   }
 
   // the vertices to be written out have to be put into a second structure
   // so that no deleted vertices (if any) exist in the list
   vector<vertSortPostMerge> vspm;
 
-  for (auto &v : vs) {
+  for (unsigned int i = 0; i < vs.size(); i++) {
+    const auto &v = vs[i];
     if (!v.deleted) {
       Color col;
       if (include_colors) {
@@ -458,7 +611,8 @@ void sort_vertices(Geometry &geom, vector<vertexMap> &vm_all_verts,
     }
 
     if (equiv_elems)
-      (*equiv_elems)[vspm.size() - 1].insert(v.vert_no);
+      (*equiv_elems)[merge_verts ? sort_grps[i] : vspm.size() - 1].insert(
+          v.vert_no);
   }
 
   // only write out the geom if not doing coincidence check
@@ -468,13 +622,13 @@ void sort_vertices(Geometry &geom, vector<vertexMap> &vm_all_verts,
       sort(vspm.begin(), vspm.end(), cmp_vert_no);
 
       // adjust the vertex maps
+      vector<int> new_to_pos(vspm.size(), -1);
+      for (unsigned j = vspm.size(); j-- > 0;)
+        new_to_pos[vspm[j].vert_new] = j;
       for (auto &vm_merged_vert : vm_merged_verts) {
-        for (unsigned j = 0; j < vspm.size(); j++) {
-          if (vspm[j].vert_new == vm_merged_vert.new_vertex) {
-            vm_merged_vert.new_vertex = j;
-            break;
-          }
-        }
+        const int new_vertex = vm_merged_vert.new_vertex;
+        if (new_vertex < (int)new_to_pos.size() && new_to_pos[new_vertex] >= 0)
+          vm_merged_vert.new_vertex = new_to_pos[new_vertex];
       }
 
       for (auto &vm_all_vert : vm_all_verts)
@@ -584,9 +738,160 @@ bool check_coincidence(const Geometry &geom1, const Geometry &geom2,
   return ret;
 }
 
+// Position of the lowest index in a face, after mapping the vertices, and
+// the direction to read the face so the second index is lower than the
+// last, giving the order faces are compared in after polygon_sort()
+static void face_key_start(const int *face, int sz, const vector<int> *v_map,
+                           int &start, int &dir)
+{
+  auto idx = [&](int i) { return v_map ? (*v_map)[face[i]] : face[i]; };
+  start = 0;
+  for (int i = 1; i < sz; i++)
+    if (idx(i) < idx(start))
+      start = i;
+  dir = 1;
+  if (sz > 2 && idx((start + 1) % sz) > idx((start + sz - 1) % sz))
+    dir = -1;
+}
+
+// Compare a face key with a face read from a start position in a
+// direction, first by size and then by index
+static int face_key_cmp(const vector<int> &key, const int *face, int sz,
+                        const vector<int> *v_map, int start, int dir)
+{
+  if ((int)key.size() != sz)
+    return ((int)key.size() < sz) ? -1 : 1;
+  for (int i = 0; i < sz; i++) {
+    int pos = (start + dir * i + sz) % sz;
+    int idx = v_map ? (*v_map)[face[pos]] : face[pos];
+    if (key[i] != idx)
+      return (key[i] < idx) ? -1 : 1;
+  }
+  return 0;
+}
+
+static long long edge_key(int v0, int v1)
+{
+  if (v0 > v1)
+    std::swap(v0, v1);
+  return (long long)v0 << 32 | (unsigned int)v1;
+}
+
+CoincidenceMatcher::CoincidenceMatcher(const Geometry &geom, double eps)
+    : geom(geom), eps(eps), valid(true), vert_idx(geom, eps)
+{
+  // each transformed vertex must be within eps of only one vertex
+  VertIndex wide_idx(geom, 2 * eps);
+  vector<int> near;
+  for (const auto &v : geom.verts()) {
+    wide_idx.find_all(v, near);
+    if (!v.is_set() || near.size() != 1) {
+      valid = false;
+      return;
+    }
+  }
+
+  for (unsigned int i = 0; i < geom.edges().size(); i++)
+    edge_keys.push_back(
+        std::make_pair(edge_key(geom.edges(i, 0), geom.edges(i, 1)), (int)i));
+  std::sort(edge_keys.begin(), edge_keys.end());
+  for (unsigned int i = 1; i < edge_keys.size(); i++)
+    if (edge_keys[i].first == edge_keys[i - 1].first)
+      valid = false;
+
+  const vector<vector<int>> &faces = geom.faces();
+  face_keys.resize(faces.size());
+  for (unsigned int i = 0; i < faces.size(); i++) {
+    const int sz = faces[i].size();
+    int start, dir;
+    face_key_start(faces[i].data(), sz, nullptr, start, dir);
+    face_keys[i].resize(sz);
+    for (int j = 0; j < sz; j++)
+      face_keys[i][j] = faces[i][(start + dir * j + sz) % sz];
+  }
+  face_order.resize(faces.size());
+  std::iota(face_order.begin(), face_order.end(), 0);
+  auto key_less = [&](int f0, int f1) {
+    const vector<int> &k0 = face_keys[f0];
+    const vector<int> &k1 = face_keys[f1];
+    return (k0.size() != k1.size()) ? k0.size() < k1.size() : k0 < k1;
+  };
+  std::sort(face_order.begin(), face_order.end(), key_less);
+  for (unsigned int i = 1; i < face_order.size(); i++)
+    if (face_keys[face_order[i]] == face_keys[face_order[i - 1]])
+      valid = false;
+}
+
+bool CoincidenceMatcher::match(const Trans3d &trans,
+                               vector<vector<int>> &elem_maps) const
+{
+  if (!valid)
+    return false;
+
+  elem_maps.resize(3);
+  const vector<Vec3d> &verts = geom.verts();
+  vector<int> &v_map = elem_maps[0];
+  v_map.resize(verts.size());
+  vector<int> &e_map = elem_maps[1];
+  e_map.assign(verts.size(), -1); // used first to find repeated images
+  for (unsigned int i = 0; i < verts.size(); i++) {
+    v_map[i] = vert_idx.find(trans * verts[i]);
+    if (v_map[i] < 0 || e_map[v_map[i]] >= 0)
+      return false;
+    e_map[v_map[i]] = i;
+  }
+
+  const vector<vector<int>> &edges = geom.edges();
+  e_map.resize(edges.size());
+  for (unsigned int i = 0; i < edges.size(); i++) {
+    auto key =
+        std::make_pair(edge_key(v_map[edges[i][0]], v_map[edges[i][1]]), -1);
+    auto ei = std::lower_bound(edge_keys.begin(), edge_keys.end(), key);
+    if (ei == edge_keys.end() || ei->first != key.first)
+      return false;
+    e_map[i] = ei->second;
+  }
+
+  // the vertex map is unique, and faces are keyed as check_coincidence()
+  // compares them, so a face with no matching key is not coincident with
+  // any face and the transformation is not a symmetry
+  const vector<vector<int>> &faces = geom.faces();
+  vector<int> &f_map = elem_maps[2];
+  f_map.resize(faces.size());
+  for (unsigned int i = 0; i < faces.size(); i++) {
+    const int *face = faces[i].data();
+    const int sz = faces[i].size();
+    int start, dir;
+    face_key_start(face, sz, &v_map, start, dir);
+    auto fi = std::lower_bound(
+        face_order.begin(), face_order.end(), 0, [&](int f, int) {
+          return face_key_cmp(face_keys[f], face, sz, &v_map, start, dir) < 0;
+        });
+    if (fi == face_order.end() ||
+        face_key_cmp(face_keys[*fi], face, sz, &v_map, start, dir) != 0)
+      return false;
+    f_map[i] = *fi;
+  }
+
+  return true;
+}
+
 void get_coincidence_maps(const Geometry &geom, Trans3d trans,
                           vector<vector<int>> &elem_maps, double eps)
 {
+  CoincidenceMatcher matcher(geom, eps);
+  vector<vector<int>> images;
+  if (matcher.match(trans, images)) {
+    // map each element to the element carried onto it
+    elem_maps.resize(3);
+    for (int i = 0; i < 3; i++) {
+      elem_maps[i].resize(images[i].size());
+      for (unsigned int j = 0; j < images[i].size(); j++)
+        elem_maps[i][images[i][j]] = j;
+    }
+    return;
+  }
+
   elem_maps.resize(3);
   Geometry tmp = geom;
   tmp.transform(trans);
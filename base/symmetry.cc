@@ -28,7 +28,9 @@
 
 #include "symmetry.h"
 #include "geometryinfo.h"
+#include "geometryutils.h"
 #include "mathutils.h"
+#include "threadpool.h"
 #include "utils.h"
 
 #include <algorithm>
@@ -795,36 +797,77 @@ Symmetry::Symmetry(const Transformations &ts)
   to_std *= transl; // first move the fixed point to the origin;
 }
 
-static inline int edge_seen(map<pair<int, int>, unsigned char> &e_seen, int v0,
-                            int v1, bool update)
+// don't export this class
+namespace {
+
+// Directions edges have been traversed in, held in a slot for each
+// connection of the lower vertex, so a path can be marked with no
+// allocation. Slots from an earlier path are cleared by a change of
+// path number.
+class EdgeMarks {
+private:
+  const vector<vector<int>> &v_cons;
+  vector<int> v_starts;          // first slot of each vertex
+  vector<unsigned char> dirs;    // 1: traversed up, 2: traversed down
+  vector<unsigned int> path_nos; // path number the slot was set for
+  unsigned int path_no = 0;
+
+public:
+  EdgeMarks(const vector<vector<int>> &cons) : v_cons(cons)
+  {
+    v_starts.resize(v_cons.size() + 1, 0);
+    for (unsigned int i = 0; i < v_cons.size(); i++)
+      v_starts[i + 1] = v_starts[i] + v_cons[i].size();
+    dirs.resize(v_starts.back());
+    path_nos.resize(v_starts.back(), 0);
+  }
+
+  // Clear the marks for a new path
+  void clear() { path_no++; }
+
+  // Directions the edge has been traversed in, with the edge given by the
+  // lower and higher vertex index numbers
+  unsigned char &get(int v0, int v1)
+  {
+    const vector<int> &cons = v_cons[v0];
+    int slot = v_starts[v0] + (find(cons.begin(), cons.end(), v1) -
+                               cons.begin());
+    if (path_nos[slot] != path_no) {
+      path_nos[slot] = path_no;
+      dirs[slot] = 0;
+    }
+    return dirs[slot];
+  }
+};
+
+} // namespace
+
+static inline int edge_seen(EdgeMarks &e_seen, int v0, int v1, bool update)
 {
   unsigned char dir = 1;
   if (v0 > v1) {
     swap(v0, v1);
     dir = 2;
   }
-  pair<int, int> edge(v0, v1);
-  auto ei = e_seen.find(edge);
-  if (ei == e_seen.end()) { // not traversed in either direction
+  unsigned char &e_dirs = e_seen.get(v0, v1);
+  if (e_dirs == 0) { // not traversed in either direction
     if (update)
-      e_seen[edge] = dir; // mark as traversed in this direction
-    return 0;             // 0: unseen
+      e_dirs = dir; // mark as traversed in this direction
+    return 0;       // 0: unseen
   }
-  if (ei->second & dir)
+  if (e_dirs & dir)
     return 2; // 2: seen and already traversed in this direction
   if (update)
-    ei->second |= dir; // mark as traversed in this direction
-  return 1;            // 1: seen but not traversed in this direction
+    e_dirs |= dir; // mark as traversed in this direction
+  return 1;        // 1: seen but not traversed in this direction
 }
 
-static inline int edge_check(map<pair<int, int>, unsigned char> &e_seen, int v0,
-                             int v1)
+static inline int edge_check(EdgeMarks &e_seen, int v0, int v1)
 {
   return edge_seen(e_seen, v0, v1, false);
 }
 
-static inline int edge_mark(map<pair<int, int>, unsigned char> &e_seen, int v0,
-                            int v1)
+static inline int edge_mark(EdgeMarks &e_seen, int v0, int v1)
 {
   return edge_seen(e_seen, v0, v1, true);
 }
@@ -837,12 +880,12 @@ static inline int edge_mark(map<pair<int, int>, unsigned char> &e_seen, int v0,
 
 static int find_path(vector<int> &path, vector<int> &v_code,
                      const vector<int> &edge, const vector<vector<int>> &v_cons,
-                     const vector<int> *test_path = nullptr,
+                     EdgeMarks &e_seen, const vector<int> *test_path = nullptr,
                      const vector<int> *test_v_code = nullptr)
 {
   path.clear();
-  v_code = vector<int>(v_cons.size(), -1);
-  map<pair<int, int>, unsigned char> e_seen;
+  v_code.assign(v_cons.size(), -1);
+  e_seen.clear();
   int v_cnt = 0;
   int v_cur = edge[0];
   path.push_back(v_cur);
@@ -911,6 +954,20 @@ static void update_equiv_elems(vector<map<int, set<int>>> &equiv_elems,
   }
 }
 
+// Equivalences given by element maps, as update_equiv_elems() would set
+// them for the coincidence check of the same transformation
+static void update_equiv_elems(vector<map<int, set<int>>> &equiv_elems,
+                               const vector<vector<int>> &elem_maps)
+{
+  for (int i = 0; i < 3; i++) {
+    for (unsigned int from = 0; from < elem_maps[i].size(); from++) {
+      set<int> &equivs = equiv_elems[i][elem_maps[i][from]];
+      equivs.insert(elem_maps[i][from]);
+      equivs.insert(from);
+    }
+  }
+}
+
 static void equiv_elems_to_sets(vector<vector<set<int>>> &equiv_sets,
                                 vector<map<int, set<int>>> &equiv_elems,
                                 vector<map<int, set<int>>> &orig_equivs)
@@ -953,20 +1010,26 @@ static void equiv_elems_to_sets(vector<vector<set<int>>> &equiv_sets,
   }
 }
 
-static bool is_sym(const Geometry &test_geom, const Geometry &geom,
-                   const vector<int> &test_v_code, const vector<int> &v_code,
-                   bool orient, Trans3d &trans,
-                   vector<map<int, set<int>>> &new_equivs)
+// Map from test path vertices to the vertices at the same position in a
+// coded path
+static void get_path_vert_map(vector<int> &v_map,
+                              const vector<int> &test_v_code,
+                              const vector<int> &v_code)
 {
-  int v_sz = test_geom.verts().size();
+  int v_sz = v_code.size();
   // code to vertex idx for this sym
   vector<int> c2v_map(v_sz);
   for (int v = 0; v < v_sz; v++)
     c2v_map[v_code[v]] = v;
-  vector<int> v_map(v_sz);
+  v_map.resize(v_sz);
   for (int v = 0; v < v_sz; v++)
     v_map[v] = c2v_map[test_v_code[v]];
+}
 
+static Trans3d get_path_trans(const Geometry &test_geom,
+                              const vector<int> &v_map, bool orient)
+{
+  int v_sz = test_geom.verts().size();
   vector<Vec3d> t_pts(3), pts(3);
   for (int i = 0; i < 2; i++) {
     t_pts[i] = test_geom.verts(i);
@@ -983,15 +1046,86 @@ static bool is_sym(const Geometry &test_geom, const Geometry &geom,
 
   if (orient)
     transform(pts, Trans3d::inversion());
-  trans = Trans3d::align(t_pts, pts);
+  Trans3d trans = Trans3d::align(t_pts, pts);
   if (orient)
     trans = Trans3d::inversion() * trans;
-  Geometry s_geom = geom;
-  s_geom.transform(trans);
+  return trans;
+}
 
-  return check_coincidence(geom, s_geom, &new_equivs, sym_eps);
+// Number the values so that values differing by no more than eps from
+// the next value in order have the same number
+static vector<int> get_value_classes(const vector<double> &vals, double eps)
+{
+  vector<int> order(vals.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&](int a, int b) { return vals[a] < vals[b]; });
+  vector<int> classes(vals.size());
+  int cls = 0;
+  for (unsigned int i = 0; i < order.size(); i++) {
+    if (i > 0 && vals[order[i]] - vals[order[i - 1]] > eps)
+      cls++;
+    classes[order[i]] = cls;
+  }
+  return classes;
+}
+
+// Number the hull vertices by properties that any symmetry must preserve:
+// the distance from the centroid, and the distance from the centroid of
+// each neighbour with the length of the edge to it. Classes are separated
+// by gaps much larger than the coincidence test allows, so a symmetry
+// never maps a vertex to one with a different number.
+static vector<int> get_vert_signatures(const Geometry &hull,
+                                       const vector<vector<int>> &v_cons)
+{
+  const double eps = 10 * sym_eps;
+  const vector<Vec3d> &verts = hull.verts();
+  Vec3d cent = hull.centroid();
+  vector<double> rads(verts.size());
+  for (unsigned int i = 0; i < verts.size(); i++)
+    rads[i] = (verts[i] - cent).len();
+  vector<int> rad_cls = get_value_classes(rads, eps);
+
+  vector<double> lens;
+  for (unsigned int i = 0; i < v_cons.size(); i++)
+    for (int v : v_cons[i])
+      lens.push_back((verts[v] - verts[i]).len());
+  vector<int> len_cls = get_value_classes(lens, eps);
+
+  map<vector<int>, int> sig_nums;
+  vector<int> sigs(verts.size());
+  vector<pair<int, int>> nbrs;
+  vector<int> sig;
+  int len_idx = 0;
+  for (unsigned int i = 0; i < v_cons.size(); i++) {
+    nbrs.clear();
+    for (int v : v_cons[i])
+      nbrs.push_back(pair<int, int>(rad_cls[v], len_cls[len_idx++]));
+    std::sort(nbrs.begin(), nbrs.end());
+    sig.assign(1, rad_cls[i]);
+    for (const auto &nbr : nbrs) {
+      sig.push_back(nbr.first);
+      sig.push_back(nbr.second);
+    }
+    auto si = sig_nums.insert(std::make_pair(sig, (int)sig_nums.size()));
+    sigs[i] = si.first->second;
+  }
+  return sigs;
 }
 
+// don't export this class
+namespace {
+
+// Result of testing a candidate symmetry
+struct SymCandidate {
+  bool is_sym = false;
+  Trans3d trans;
+  vector<vector<int>> elem_maps;         // equivalences, if tested by matcher
+  vector<map<int, set<int>>> new_equivs; // equivalences, if by coincidence
+};
+
+} // namespace
+
 static void set_equiv_elems_identity(const Geometry &geom,
                                      vector<vector<set<int>>> *equiv_sets)
 {
@@ -1007,7 +1141,7 @@ static void set_equiv_elems_identity(const Geometry &geom,
 }
 
 static int find_syms(const Geometry &geom, Transformations &ts,
-                     vector<vector<set<int>>> *equiv_sets)
+                     vector<vector<set<int>>> *equiv_sets, int num_threads)
 {
   ts.clear();
 
@@ -1040,31 +1174,76 @@ static int find_syms(const Geometry &geom, Transformations &ts,
     reverse(r_con.begin(), r_con.end());
   const vector<vector<int>> *cons[] = {&v_cons, &r_cons};
 
+  vector<int> test_path, test_v_code;
+  EdgeMarks test_seen(v_cons);
+  find_path(test_path, test_v_code, *edges.begin(), v_cons, test_seen);
+
+  // Candidates are rejected by the vertex signatures, then tested with a
+  // coincidence matcher, and the full coincidence check is only made when
+  // the geometry is not suitable for the matcher
+  vector<int> v_sigs = get_vert_signatures(test_geom, v_cons);
+  CoincidenceMatcher matcher(merged_geom, sym_eps);
+
+  // A candidate maps the test path start to an edge, in either direction,
+  // with either orientation. Candidates are independent, so are tested
+  // in parallel when threads are requested and there is enough work, and
+  // then the results are combined in candidate order.
+  const int num_cands = 4 * edges.size();
+  const double work = (double)num_cands * merged_geom.verts().size();
+  ThreadPool pool((work > 1e6) ? num_threads : 1);
+  const int num_parts = (pool.get_num_threads() > 1)
+                            ? std::min(num_cands, 4 * pool.get_num_threads())
+                            : 1;
+  vector<SymCandidate> cands(num_cands);
+  pool.run(num_parts, [&](int part) {
+    vector<int> path, v_code, v_map;
+    EdgeMarks e_seen(v_cons);
+    vector<vector<int>> elem_maps;
+    const int end = part_start(num_cands, num_parts, part + 1);
+    for (int c = part_start(num_cands, num_parts, part); c < end; c++) {
+      const int orient = c % 2;
+      vector<int> edge = edges[c / 4];
+      if ((c / 2) % 2)
+        swap(edge[0], edge[1]);
+      if (!find_path(path, v_code, edge, *cons[orient], e_seen, &test_path,
+                     &test_v_code))
+        continue;
+
+      get_path_vert_map(v_map, test_v_code, v_code);
+      bool sigs_match = true;
+      for (unsigned int v = 0; v < v_map.size() && sigs_match; v++)
+        sigs_match = (v_sigs[v] == v_sigs[v_map[v]]);
+      if (!sigs_match)
+        continue;
+
+      SymCandidate &cand = cands[c];
+      cand.trans = get_path_trans(test_geom, v_map, orient);
+      if (matcher.is_valid()) {
+        cand.is_sym = matcher.match(cand.trans, elem_maps);
+        if (cand.is_sym && equiv_sets)
+          cand.elem_maps = elem_maps;
+      }
+      else {
+        Geometry s_geom = merged_geom;
+        s_geom.transform(cand.trans);
+        cand.is_sym = check_coincidence(merged_geom, s_geom, &cand.new_equivs,
+                                        sym_eps);
+      }
+    }
+  });
+
   vector<map<int, set<int>>> equiv_elems(3);
   int cnts[3] = {(int)merged_geom.verts().size(),
                  (int)merged_geom.edges().size(),
                  (int)merged_geom.faces().size()};
-  vector<int> test_path, path;
-  vector<int> test_v_code, v_code;
-  find_path(test_path, test_v_code, *edges.begin(), v_cons);
-  vector<vector<int>>::const_iterator ei;
-  for (ei = edges.begin(); ei != edges.end(); ei++) {
-    vector<int> edge = *ei;
-    for (int i = 0; i < 2; i++) {
-      if (i)
-        swap(edge[0], edge[1]);
-      for (int orient = 0; orient < 2; orient++) {
-        if (find_path(path, v_code, edge, *cons[orient], &test_path,
-                      &test_v_code)) {
-          Trans3d trans;
-          vector<map<int, set<int>>> new_equivs;
-          if (is_sym(test_geom, merged_geom, test_v_code, v_code, orient, trans,
-                     new_equivs)) {
-            ts.add(trans);
-            if (equiv_sets)
-              update_equiv_elems(equiv_elems, new_equivs, cnts);
-          }
-        }
+  for (const auto &cand : cands) {
+    if (cand.is_sym) {
+      ts.add(cand.trans);
+      if (equiv_sets) {
+        if (cand.elem_maps.size())
+          update_equiv_elems(equiv_elems, cand.elem_maps);
+        else
+          update_equiv_elems(equiv_elems, cand.new_equivs, cnts);
       }
     }
   }
@@ -1086,9 +1265,10 @@ const char *type_str[Symmetry::Ih + 1] = {
     "Unknown", "C1", "Ci", "Cs", "C",  "Cv", "Ch", "D", "Dv",
     "Dh",      "S",  "T",  "Td", "Th", "O",  "Oh", "I", "Ih"};
 
-Symmetry::Symmetry(const Geometry &geom, vector<vector<set<int>>> *equiv_sets)
+Symmetry::Symmetry(const Geometry &geom, vector<vector<set<int>>> *equiv_sets,
+                   int num_threads)
 {
-  init(geom, equiv_sets);
+  init(geom, equiv_sets, num_threads);
 }
 
 Symmetry::Symmetry(int type, int n, const Trans3d &pos, Status *stat)
@@ -1111,11 +1291,11 @@ Symmetry::Symmetry(const SymmetryAxis &sym_axis, const Vec3d &cent)
 }
 
 Status Symmetry::init(const Geometry &geom,
-                      vector<vector<set<int>>> *equiv_sets)
+                      vector<vector<set<int>>> *equiv_sets, int num_threads)
 {
   sym_type = unknown;
   Transformations ts;
-  find_syms(geom, ts, equiv_sets);
+  find_syms(geom, ts, equiv_sets, num_threads);
   *this = Symmetry(ts);
   return (sym_type != unknown)
              ? Status::ok()
@@ -1310,7 +1490,13 @@ void get_equiv_elems(const Geometry &geom, const Transformations &ts,
                  (int)merged_geom.edges().size(),
                  (int)merged_geom.faces().size()};
 
+  CoincidenceMatcher matcher(merged_geom, sym_eps);
+  vector<vector<int>> elem_maps;
   for (const auto &t : ts) {
+    if (matcher.match(t, elem_maps)) {
+      update_equiv_elems(equiv_elems, elem_maps);
+      continue;
+    }
     Geometry trans_geom = merged_geom;
     trans_geom.transform(t);
     vector<map<int, set<int>>> new_equivs;
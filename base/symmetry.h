@@ -477,9 +477,12 @@ public:
   /** Find the symmetry in Schoenflies notation.
    * \param geom geometry to find the symmetry type for.
    * \param equiv_sets for the vertices, edges and faces set up a
-   *  vector of sets of equivalent elements. */
+   *  vector of sets of equivalent elements.
+   * \param num_threads the number of threads used to test candidate
+   *  symmetries, or \c 0 for the number of processors. */
   Symmetry(const Geometry &geom,
-           std::vector<std::vector<std::set<int>>> *equiv_sets = nullptr);
+           std::vector<std::vector<std::set<int>>> *equiv_sets = nullptr,
+           int num_threads = 1);
 
   /// Constructor
   /** Find the symmetry in Schoenflies notation.
@@ -513,10 +516,13 @@ public:
    * \param geom geometry to find the symmetry type for.
    * \param equiv_sets for the vertices, edges and faces set up a
    *  vector of sets of equivalent elements
+   * \param num_threads the number of threads used to test candidate
+   *  symmetries, or \c 0 for the number of processors.
    * \return status, evaluates to \c true if the symmetry type
    *  could be determined, otherwise \c false.*/
   Status init(const Geometry &geom,
-              std::vector<std::vector<std::set<int>>> *equiv_sets = nullptr);
+              std::vector<std::vector<std::set<int>>> *equiv_sets = nullptr,
+              int num_threads = 1);
 
   /// Initialiser
   /**\param type the symmetry type.
@@ -0,0 +1,114 @@
+/*
+   Copyright (c) 2023, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/**\file threadpool.cc
+   \brief A pool of threads for running independent tasks
+*/
+
+#include "threadpool.h"
+
+using std::mutex;
+using std::thread;
+using std::unique_lock;
+
+namespace anti {
+
+ThreadPool::ThreadPool(int num_threads) : next_task(0)
+{
+  if (num_threads <= 0)
+    num_threads = get_num_processors();
+  for (int i = 0; i < num_threads - 1; i++)
+    workers.push_back(thread(&ThreadPool::work_loop, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    unique_lock<mutex> lock(mtx);
+    stopping = true;
+  }
+  work_cv.notify_all();
+  for (auto &worker : workers)
+    worker.join();
+}
+
+int ThreadPool::get_num_processors()
+{
+  int num = thread::hardware_concurrency();
+  return (num > 0) ? num : 1;
+}
+
+void ThreadPool::do_tasks()
+{
+  int task_no;
+  while ((task_no = next_task++) < cur_num_tasks)
+    (*cur_task)(task_no);
+}
+
+void ThreadPool::work_loop()
+{
+  unsigned long last_run = 0;
+  while (true) {
+    {
+      unique_lock<mutex> lock(mtx);
+      work_cv.wait(lock, [&] { return stopping || run_cnt != last_run; });
+      if (stopping)
+        return;
+      last_run = run_cnt;
+    }
+
+    do_tasks();
+
+    unique_lock<mutex> lock(mtx);
+    if (--active_workers == 0)
+      done_cv.notify_one();
+  }
+}
+
+void ThreadPool::run(int num_tasks, const std::function<void(int)> &task)
+{
+  if (workers.empty() || num_tasks < 2) {
+    for (int i = 0; i < num_tasks; i++)
+      task(i);
+    return;
+  }
+
+  {
+    unique_lock<mutex> lock(mtx);
+    cur_task = &task;
+    cur_num_tasks = num_tasks;
+    next_task = 0;
+    active_workers = workers.size();
+    run_cnt++;
+  }
+  work_cv.notify_all();
+
+  do_tasks();
+
+  unique_lock<mutex> lock(mtx);
+  done_cv.wait(lock, [&] { return active_workers == 0; });
+  cur_task = nullptr;
+}
+
+} // namespace anti
@@ -0,0 +1,103 @@
+/*
+   Copyright (c) 2023, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/**\file threadpool.h
+   \brief A pool of threads for running independent tasks
+*/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace anti {
+
+/// A pool of threads for running independent tasks
+/** The threads are started once and wait between runs, so a pool can be
+ *  used on each iteration of a calculation. The thread that calls \c run()
+ *  also works on the tasks. Tasks may be run in any order and on any
+ *  thread, so for repeatable results a task should write only to its own
+ *  storage, and the results should be combined in task order after
+ *  \c run() has returned. */
+class ThreadPool {
+private:
+  std::vector<std::thread> workers;
+  std::mutex mtx;
+  std::condition_variable work_cv;
+  std::condition_variable done_cv;
+  const std::function<void(int)> *cur_task = nullptr;
+  int cur_num_tasks = 0;
+  std::atomic<int> next_task;
+  int active_workers = 0;
+  unsigned long run_cnt = 0; // incremented for each run
+  bool stopping = false;
+
+  void work_loop();
+  void do_tasks();
+
+public:
+  /// Constructor
+  /**\param num_threads the number of threads, including the calling
+   *  thread, or \c 0 for the number of processors. */
+  ThreadPool(int num_threads = 0);
+
+  /// Destructor
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /// Get the number of threads
+  /**\return The number of threads, including the calling thread. */
+  int get_num_threads() const { return workers.size() + 1; }
+
+  /// Run tasks, and wait until they have all finished
+  /**\param num_tasks the number of tasks
+   * \param task function to call with each task number, from \c 0 to
+   *  \c num_tasks-1 */
+  void run(int num_tasks, const std::function<void(int)> &task);
+
+  /// Get the number of processors
+  /**\return The number of processors, or \c 1 if it is not known. */
+  static int get_num_processors();
+};
+
+/// Get the start of a range of items, when divided into consecutive parts
+/**\param num_items the number of items.
+ * \param num_parts the number of parts.
+ * \param part the part number (\c num_parts for the end of the range.)
+ * \return The index of the first item in the part. */
+inline int part_start(int num_items, int num_parts, int part)
+{
+  return (int)((long long)num_items * part / num_parts);
+}
+
+} // namespace anti
+
+#endif // THREADPOOL_H
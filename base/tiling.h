@@ -255,6 +255,8 @@ private:
   // std::vector<Vec3d> vert_norms;            ///< Base tiling vertex normals
 
   bool one_of_each_tile; ///< Only plot one tile per kind
+  bool merge_doubled;    ///< Merge tiles doubled by starting everywhere
+  int num_threads;       ///< Number of threads to find circuits with
 
   /// Find base tiling face neighbours
   /** \return Status, which evaluates to \c true if the nieghbours were
@@ -278,25 +280,28 @@ private:
   int get_associated_element(int start_idx, const std::string &step,
                              int assoc_type) const;
 
-  /// Add a circuit (face) for an individual tile pattern
-  /**\param geom the geometry to add the circuit face to
-   * \param start_index the base triangle to start the circuit
-   * \param seen base triangles that have already been used
-   * \param index order used to calculate final vertex index numbers
-   * \param point_vertex_offsets used to calculate final vertex index numbers */
-  void
-  add_circuit(Geometry &geom, int start_idx, const Tile &pat,
-              std::vector<bool> &seen, Color col,
-              const std::vector<std::map<std::vector<int>, std::pair<int, int>>>
-                  &index_order,
-              const std::vector<int> &point_vertex_offsets) const;
+  /// Find a circuit (face) for an individual tile pattern
+  /**\param start_idx the base triangle to start the circuit
+   * \param pat the tile pattern
+   * \param elem_orders for each point inclusion type, the order of the
+   *  element on each base triangle, used to calculate final vertex index
+   *  numbers
+   * \param point_vertex_offsets used to calculate final vertex index numbers
+   * \param face to return the circuit face
+   * \param tris to return the base triangles used by the circuit
+   * \return \c true if the circuit completed, otherwise \c false if it
+   *  was abandoned at an open edge. */
+  bool find_circuit(int start_idx, const Tile &pat,
+                    const std::vector<std::vector<int>> &elem_orders,
+                    const std::vector<int> &point_vertex_offsets,
+                    std::vector<int> &face, std::vector<int> &tris) const;
   /// Get the tile patterns
   /** \return The tile patterns. */
   const std::vector<Tile> &get_pat_paths() const { return pat_paths; }
 
 public:
   /// Constructor
-  Tiling() : one_of_each_tile(false) {}
+  Tiling() : one_of_each_tile(false), merge_doubled(false), num_threads(1) {}
 
   /// Set the base geometry
   /**\param geom the base geometry
@@ -381,6 +386,20 @@ public:
   /**\param val \c true, only one of each kind, otherwise \c false, all */
   void set_one_of_each_tile(bool val = true) { one_of_each_tile = val; };
 
+  /// Set that doubled tiles should be merged
+  /**Tiles may be doubled when they start on both kinds of triangle. A
+   * tile is doubled if it has the same vertices as an earlier tile, and
+   * only the first is kept.
+   * \param val \c true, merge doubled tiles, otherwise \c false, keep all */
+  void set_merge_doubled_tiles(bool val = true) { merge_doubled = val; };
+
+  /// Set the number of threads used to make the tiling
+  /**\param num the number of threads, or \c 0 for the number of
+   *  processors. The tiling is the same for any number of threads.
+   * \return Status, which evaluates to \c true if the number was valid,
+   *  otherwise \c false to indicate an error. */
+  Status set_num_threads(int num);
+
   /// Get a Wythoff constructive notation string representing the pattern
   /**\return The pattern string. */
   std::string pattern_string();
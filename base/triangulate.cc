@@ -217,8 +217,7 @@ void triangulate(Geometry &geom, Color inv, unsigned int winding,
   vector<vector<int>> faces = geom.faces();
   vector<vector<int>> impl_edges;
   geom.get_impl_edges(impl_edges);
-  map<int, Color> fcolmap;
-  fcolmap = geom.colors(FACES).get_properties();
+  ElemProps<Color> fcols = geom.colors(FACES);
   geom.clear(FACES);
 
   const vector<Vec3d> &verts = geom.verts();
@@ -230,10 +229,7 @@ void triangulate(Geometry &geom, Color inv, unsigned int winding,
       fmap->push_back(geom.faces().size());
     if (faces[i].size() < 3)
       continue;
-    Color col;
-    auto mi = fcolmap.find(i);
-    if (mi != fcolmap.end())
-      col = mi->second;
+    Color col = fcols.get(i);
 
     face_tris f_tris(&geom, col, inv);
     localgluTessBeginPolygon(tess, &f_tris);
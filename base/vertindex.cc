@@ -0,0 +1,186 @@
+/*
+   Copyright (c) 2023, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/*!\file vertindex.cc
+   \brief Spatial index for finding vertices by coordinates
+*/
+
+#include "vertindex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using std::vector;
+
+namespace anti {
+
+// Cells are never narrower than this, so that the cell coordinates of
+// models with large coordinates and a tiny eps stay well distributed
+static const double min_cell_sz = 1e-10;
+
+// Cell coordinates are clamped to this range. Clamping does not move
+// cells further apart, so a neighbourhood search stays correct.
+static const double max_cell_coord = 1e17;
+
+size_t VertIndex::CellHash::operator()(const Cell &c) const
+{
+  size_t h = (size_t)c.x * 73856093u;
+  h ^= (size_t)c.y * 19349663u + (h << 6) + (h >> 2);
+  h ^= (size_t)c.z * 83492791u + (h << 6) + (h >> 2);
+  return h;
+}
+
+VertIndex::VertIndex(const vector<Vec3d> &vrts, double eps)
+    : verts(&vrts), eps(eps), cell_sz(std::max(eps, min_cell_sz))
+{
+  update();
+}
+
+VertIndex::VertIndex(const Geometry &geom, double eps)
+    : VertIndex(geom.verts(), eps)
+{
+}
+
+VertIndex::Cell VertIndex::get_cell(const Vec3d &v) const
+{
+  long long c[3];
+  for (int i = 0; i < 3; i++) {
+    double coord = floor(v[i] / cell_sz);
+    c[i] = (long long)std::max(-max_cell_coord,
+                               std::min(max_cell_coord, coord));
+  }
+  return {c[0], c[1], c[2]};
+}
+
+void VertIndex::add_idx(int v_idx)
+{
+  const Vec3d &v = (*verts)[v_idx];
+  if (!v.is_set()) {
+    unset_verts.push_back(v_idx);
+    next_in_cell.push_back(-1);
+    return;
+  }
+
+  auto ret = cell_heads.insert(std::make_pair(get_cell(v), v_idx));
+  if (ret.second)
+    next_in_cell.push_back(-1);
+  else {
+    next_in_cell.push_back(ret.first->second);
+    ret.first->second = v_idx;
+  }
+}
+
+void VertIndex::update()
+{
+  if (next_in_cell.size() > verts->size()) {
+    rebuild();
+    return;
+  }
+  for (int i = next_in_cell.size(); i < (int)verts->size(); i++)
+    add_idx(i);
+}
+
+void VertIndex::rebuild()
+{
+  cell_heads.clear();
+  next_in_cell.clear();
+  unset_verts.clear();
+  update();
+}
+
+bool VertIndex::is_at(int v_idx, const Vec3d &coords) const
+{
+  const Vec3d &v = (*verts)[v_idx];
+  if (!coords.is_set())
+    return !v.is_set();
+  return v.is_set() && !compare(v, coords, eps);
+}
+
+int VertIndex::find(const Vec3d &coords) const
+{
+  // the vertex list may have changed size since the last update
+  const int sz = verts->size();
+  int v_idx = -1;
+  if (!coords.is_set()) {
+    for (int idx : unset_verts)
+      if (idx < sz)
+        return idx;
+  }
+  else {
+    const Cell cell = get_cell(coords);
+    for (int i = -1; i < 2; i++)
+      for (int j = -1; j < 2; j++)
+        for (int k = -1; k < 2; k++) {
+          const auto it =
+              cell_heads.find({cell.x + i, cell.y + j, cell.z + k});
+          if (it == cell_heads.end())
+            continue;
+          for (int idx = it->second; idx >= 0; idx = next_in_cell[idx])
+            if (idx < sz && (v_idx < 0 || idx < v_idx) &&
+                !compare((*verts)[idx], coords, eps))
+              v_idx = idx;
+        }
+  }
+
+  // vertices not yet indexed have higher index numbers
+  for (int idx = next_in_cell.size(); v_idx < 0 && idx < sz; idx++)
+    if (is_at(idx, coords))
+      v_idx = idx;
+
+  return v_idx;
+}
+
+void VertIndex::find_all(const Vec3d &coords, vector<int> &v_idxs) const
+{
+  const int sz = verts->size();
+  v_idxs.clear();
+  if (!coords.is_set()) {
+    for (int idx : unset_verts)
+      if (idx < sz)
+        v_idxs.push_back(idx);
+  }
+  else {
+    const Cell cell = get_cell(coords);
+    for (int i = -1; i < 2; i++)
+      for (int j = -1; j < 2; j++)
+        for (int k = -1; k < 2; k++) {
+          const auto it =
+              cell_heads.find({cell.x + i, cell.y + j, cell.z + k});
+          if (it == cell_heads.end())
+            continue;
+          for (int idx = it->second; idx >= 0; idx = next_in_cell[idx])
+            if (idx < sz && !compare((*verts)[idx], coords, eps))
+              v_idxs.push_back(idx);
+        }
+    std::sort(v_idxs.begin(), v_idxs.end());
+  }
+
+  // vertices not yet indexed have higher index numbers
+  for (int idx = next_in_cell.size(); idx < sz; idx++)
+    if (is_at(idx, coords))
+      v_idxs.push_back(idx);
+}
+
+} // namespace anti
@@ -0,0 +1,121 @@
+/*
+   Copyright (c) 2023, Adrian Rossiter
+
+   Antiprism - http://www.antiprism.com
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+      The above copyright notice and this permission notice shall be included
+      in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+/*!\file vertindex.h
+   \brief Spatial index for finding vertices by coordinates
+*/
+
+#ifndef VERTINDEX_H
+#define VERTINDEX_H
+
+#include "geometry.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace anti {
+
+/// Spatial index of vertex coordinates
+/** The vertices are hashed into a uniform grid of cells that are at least
+ *  \c eps wide, so a coordinate lookup only needs to check the vertices
+ *  in the neighbouring cells. The index refers to the vertex list, rather
+ *  than copying it. Vertices appended to the list after the index was
+ *  made are checked one by one until \c update() is called, and
+ *  vertices past the end of a shortened list are skipped, but if
+ *  vertices are moved or deleted then \c rebuild() must be called.
+ *  Lookups do not change the index, so they may be made from several
+ *  threads at once.
+ *  Coincidence is tested with \c compare(), as in
+ *  \c find_vert_by_coords(). */
+class VertIndex {
+public:
+  /// Grid cell coordinates
+  struct Cell {
+    long long x, y, z;
+    bool operator==(const Cell &c) const
+    {
+      return x == c.x && y == c.y && z == c.z;
+    }
+  };
+
+  /// Hash for grid cell coordinates
+  struct CellHash {
+    size_t operator()(const Cell &c) const;
+  };
+
+private:
+  const std::vector<Vec3d> *verts;
+  double eps;
+  double cell_sz;
+  std::unordered_map<Cell, int, CellHash> cell_heads; // first vert in cell
+  std::vector<int> next_in_cell; // next vert in same cell, or -1
+  std::vector<int> unset_verts;  // vertices without coordinates
+
+  Cell get_cell(const Vec3d &v) const;
+  void add_idx(int v_idx);
+  bool is_at(int v_idx, const Vec3d &coords) const;
+
+public:
+  /// Constructor
+  /**\param vrts the vertices to index, the index refers to this list.
+   * \param eps a small number, coordinates differing by less than eps are
+   *  the same. */
+  VertIndex(const std::vector<Vec3d> &vrts, double eps = epsilon);
+
+  /// Constructor
+  /**\param geom the geometry whose vertices will be indexed, the index
+   *  refers to this geometry.
+   * \param eps a small number, coordinates differing by less than eps are
+   *  the same. */
+  VertIndex(const Geometry &geom, double eps = epsilon);
+
+  /// Add any vertices appended to the vertex list since the last update
+  /** Lookups also find these vertices, but more slowly. The index is
+   *  rebuilt if the vertex list has been shortened. */
+  void update();
+
+  /// Rebuild the index
+  /** Call after the vertex list has been changed other than by appending
+   *  vertices. */
+  void rebuild();
+
+  /// Find the index number of a vertex with a set of coordinates
+  /**\param coords the coordinates
+   * \return The coincident vertex with lowest index number, otherwise -1 */
+  int find(const Vec3d &coords) const;
+
+  /// Find the index numbers of all the vertices with a set of coordinates
+  /**\param coords the coordinates
+   * \param v_idxs used to return the coincident vertex index numbers, in
+   *  ascending order. */
+  void find_all(const Vec3d &coords, std::vector<int> &v_idxs) const;
+
+  /// Get the coincidence limit
+  /**\return The coincidence limit */
+  double get_eps() const { return eps; }
+};
+
+} // namespace anti
+
+#endif // VERTINDEX_H
@@ -24,9 +24,11 @@
 
 #include "geometryinfo.h"
 #include "programopts.h"
+#include "threadpool.h"
 #include "tiling.h"
 #include "utils.h"
 
+#include <algorithm>
 #include <cstring>
 #include <map>
 #include <regex>
@@ -34,7 +36,6 @@
 #include <vector>
 
 using std::map;
-using std::pair;
 using std::string;
 using std::to_string;
 using std::vector;
@@ -119,7 +120,7 @@ static void make_meta(const Geometry &geom, Geometry &meta,
 static Status normalize_tri(Geometry &geom, int f_idx, int v0, int v1,
                             Color other_v_col)
 {
-  vector<int> &face = geom.faces(f_idx);
+  vector<int> &face = geom.raw_faces(f_idx);
   if (face.size() != 3)
     return Status::error(msg_str("face %d is not a triangle", f_idx));
   bool found = false;
@@ -377,26 +378,17 @@ string TilingColoring::get_option_help(char op_char)
 
 bool Tiling::find_nbrs()
 {
-  auto ef_pairs = meta.get_edge_face_pairs(false);
+  const auto hes_ptr = meta.get_half_edges();
+  const HalfEdges &hes = *hes_ptr;
 
-  // Find the neighbour face opposite each VEF vertex
+  // Find the neighbour face opposite each VEF vertex, which is the face
+  // on the side starting at the next vertex. Only allow connection for
+  // two faces at an edge
   nbrs.resize(meta.faces().size(), vector<int>(3));
   for (unsigned int f = 0; f < meta.faces().size(); f++)
     for (int i = 0; i < 3; i++) {
-      vector<int> e(2);
-      e[0] = meta.faces_mod(f, i + 1);
-      e[1] = meta.faces_mod(f, i + 2);
-      if (e[0] > e[1])
-        std::swap(e[0], e[1]);
-      auto ef_i = ef_pairs.find(e);
-      if (ef_i == ef_pairs.end())
-        return false;
-      else if (ef_i->second.size() != 2)
-        nbrs[f][i] = -1; // only allow connection for two faces at an edge
-      else {
-        nbrs[f][i] =
-            (ef_i->second[0] != (int)f) ? ef_i->second[0] : ef_i->second[1];
-      }
+      const int he = hes.partner(hes.face_start(f) + (i + 1) % 3);
+      nbrs[f][i] = (he >= 0) ? hes.face(he) : -1;
     }
   return true;
 }
@@ -448,55 +440,30 @@ int Tiling::get_associated_element(int start_idx, const string &step,
   return idx >= 0 ? meta.faces(idx, assoc_type) : idx;
 }
 
-// Each pattern point plotted for a meta triangle cooresponds to
-// a previously assigned geometry vertex. Get the index of that vertex.
-static int
-get_index(const vector<int> &face, int f_idx, int pat_pt_idx, int incl,
-          const std::vector<std::map<std::vector<int>, std::pair<int, int>>>
-              &index_order,
-          const std::vector<int> &point_vertex_offsets)
-{
-  vector<int> incl_key;
-  if (incl >= Tile::V && incl <= Tile::F) // meta tile vertex
-    incl_key = {face[incl]};
-  else if (incl >= Tile::VE && incl <= Tile::FV) // meta tile edge
-    incl_key = make_edge(face[incl % 3], face[(incl + 1) % 3]);
-  else if (incl == Tile::VEF) // meta tile interior
-    incl_key = {f_idx};
-  else
-    return -1; // invalid inclusion value, shouldn't happen
-
-  const auto it = index_order[incl].find(incl_key);
-  if (it == index_order[incl].end())
-    return -2; // invalid element key, shouldn't happen
-
-  return point_vertex_offsets[pat_pt_idx] + it->second.first;
-}
-
-void Tiling::add_circuit(
-    Geometry &geom, int start_idx, const Tile &pat, std::vector<bool> &seen,
-    Color col,
-    const std::vector<std::map<std::vector<int>, std::pair<int, int>>>
-        &index_order,
-    const std::vector<int> &point_vertex_offsets) const
+bool Tiling::find_circuit(int start_idx, const Tile &pat,
+                          const vector<vector<int>> &elem_orders,
+                          const vector<int> &point_vertex_offsets,
+                          vector<int> &face, vector<int> &tris) const
 {
   // Apply pattern until circuit completes
-  vector<int> face;
+  face.clear();
+  tris.clear();
   int idx = start_idx;
   while (true) {
-    seen[idx] = true;
+    tris.push_back(idx);
     pat.start_op();
     while (pat.get_op() != Tile::END) {
       if (pat.get_op() == Tile::P) {
-        int incl = points[pat.get_idx()].get_inclusion();
-        int v_idx = get_index(meta.faces(idx), idx, pat.get_idx(), incl,
-                              index_order, point_vertex_offsets);
-        face.push_back(v_idx);
+        // Each pattern point plotted for a meta triangle cooresponds to
+        // a previously assigned geometry vertex
+        const int pt_idx = pat.get_idx();
+        const int incl = points[pt_idx].get_inclusion();
+        face.push_back(point_vertex_offsets[pt_idx] + elem_orders[incl][idx]);
       }
       else {
         idx = nbrs[idx][pat.get_op()]; // move to next triangle
         if (idx < 0)
-          return; // abandon: circuit tried to cross an open edge
+          return false; // abandon: circuit tried to cross an open edge
       }
       pat.next_op();
     }
@@ -504,7 +471,7 @@ void Tiling::add_circuit(
       break;
   }
 
-  geom.add_face(face, col);
+  return true;
 }
 
 static void reverse_odd_faces(Geometry &geom)
@@ -512,7 +479,7 @@ static void reverse_odd_faces(Geometry &geom)
   const int f_sz = geom.faces().size();
   for (int i = 0; i < f_sz; i++)
     if (i % 2)
-      reverse(geom.faces(i).begin(), geom.faces(i).end());
+      reverse(geom.raw_faces(i).begin(), geom.raw_faces(i).end());
 }
 
 Status Tiling::set_geom(const Geometry &geom, bool is_meta, double face_ht)
@@ -565,6 +532,14 @@ void Tiling::start_everywhere()
     path.set_start_faces('*');
 }
 
+Status Tiling::set_num_threads(int num)
+{
+  if (num < 0)
+    return Status::error("number of threads cannot be negative");
+  num_threads = num;
+  return Status::ok();
+}
+
 namespace {
 
 void delete_verts(Geometry &geom, const vector<int> &v_nos)
@@ -611,15 +586,103 @@ bool valid_start_face(int f, int start_faces)
   return !((start_faces == '-' && pos_tri) || (start_faces == '+' && !pos_tri));
 }
 
-void store_tri(map<vector<int>, pair<int, int>> &elem_to_tri, vector<int> key,
-               int tri_idx)
+// For each point inclusion type V, E, F, VE, EF, FV, VEF, find the order
+// of the element on each meta triangle (to find index of corresponding
+// point) and an example triangle for each element (to generate coordinates
+// of corresponding point). Elements are ordered by their vertex index
+// numbers, or triangle index number for VEF.
+void find_element_orders(const Geometry &meta,
+                         vector<vector<int>> &elem_orders,
+                         vector<vector<int>> &example_tris)
 {
-  auto pr = elem_to_tri.insert({key, {-1, tri_idx}});
-  if (pr.second == false && is_even(pr.first->second.second) &&
-      !is_even(tri_idx))
-    pr.first->second.second = tri_idx;
+  const int faces_sz = meta.faces().size();
+  elem_orders.assign(Tile::VEF + 1, vector<int>(faces_sz));
+  example_tris.assign(Tile::VEF + 1, vector<int>());
+
+  for (int i = 0; i < faces_sz; i++)
+    elem_orders[Tile::VEF][i] = i;
+  example_tris[Tile::VEF] = elem_orders[Tile::VEF];
+
+  // Vertex elements, the example is the last triangle
+  const int verts_sz = meta.verts().size();
+  for (int incl = Tile::V; incl <= Tile::F; incl++) {
+    vector<int> v_tris(verts_sz, -1);
+    for (int i = 0; i < faces_sz; i++)
+      v_tris[meta.faces(i, incl)] = i;
+    vector<int> v_orders(verts_sz, -1);
+    for (int v = 0; v < verts_sz; v++)
+      if (v_tris[v] >= 0) {
+        v_orders[v] = example_tris[incl].size();
+        example_tris[incl].push_back(v_tris[v]);
+      }
+    for (int i = 0; i < faces_sz; i++)
+      elem_orders[incl][i] = v_orders[meta.faces(i, incl)];
+  }
+
+  // Edge elements, on the triangle side starting at the first vertex of
+  // the inclusion type. The implicit edges are in vertex index order. The
+  // example is the last triangle, except for VE, where it is the first
+  // odd triangle, or the first triangle if none are odd
+  const auto hes_ptr = meta.get_half_edges();
+  const HalfEdges &hes = *hes_ptr;
+  const int edges_sz = hes.num_edges();
+  for (int incl = Tile::VE; incl <= Tile::FV; incl++) {
+    const int side = incl - Tile::VE;
+    vector<int> e_tris(edges_sz, -1);
+    for (int i = 0; i < faces_sz; i++) {
+      int &tri = e_tris[hes.edge(hes.face_start(i) + side)];
+      if (incl != Tile::VE || tri < 0 || (is_even(tri) && !is_even(i)))
+        tri = i;
+    }
+    vector<int> e_orders(edges_sz, -1);
+    for (int e = 0; e < edges_sz; e++)
+      if (e_tris[e] >= 0) {
+        e_orders[e] = example_tris[incl].size();
+        example_tris[incl].push_back(e_tris[e]);
+      }
+    for (int i = 0; i < faces_sz; i++)
+      elem_orders[incl][i] = e_orders[hes.edge(hes.face_start(i) + side)];
+  }
 }
 
+// Delete faces that have the same vertex cycle as an earlier face,
+// in either direction, keeping the earlier face
+void delete_doubled_faces(Geometry &geom)
+{
+  const int faces_sz = geom.faces().size();
+  vector<vector<int>> cycles(faces_sz);
+  for (int i = 0; i < faces_sz; i++) {
+    auto &cycle = cycles[i];
+    cycle = geom.faces(i);
+    if (cycle.size() < 2)
+      continue;
+    std::rotate(cycle.begin(), min_element(cycle.begin(), cycle.end()),
+                cycle.end());
+    if (cycle[1] > cycle.back())
+      reverse(cycle.begin() + 1, cycle.end());
+  }
+
+  vector<int> order(faces_sz);
+  for (int i = 0; i < faces_sz; i++)
+    order[i] = i;
+  stable_sort(order.begin(), order.end(),
+              [&](int i0, int i1) { return cycles[i0] < cycles[i1]; });
+
+  vector<int> dels;
+  for (int i = 1; i < faces_sz; i++)
+    if (cycles[order[i]] == cycles[order[i - 1]])
+      dels.push_back(order[i]);
+  geom.del(FACES, dels);
+}
+
+// A circuit found from a start triangle
+struct Circuit {
+  int start;         // start triangle
+  bool complete;     // circuit completed, and was not abandoned
+  vector<int> face;  // circuit face
+  vector<int> tris;  // triangles used by the circuit
+};
+
 }; // namespace
 
 Status Tiling::make_tiling(Geometry &geom,
@@ -630,26 +693,9 @@ Status Tiling::make_tiling(Geometry &geom,
     tile_reports->resize(pat_paths.size());
 
   // All the possible element inclusion postions V, E, F, VE, EF, FV, VEF.
-  // Each entry maps to order (to find index of corresponding point)
-  // and example triangle (to generate coordinates of corresponding point)
-  auto ef_pairs = meta.get_edge_face_pairs();
-  vector<map<vector<int>, pair<int, int>>> index_order(7);
-  for (int i = 0; i < (int)meta.faces().size(); i++) {
-    const auto &face = meta.faces(i);
-    index_order[Tile::VEF][{i}] = {-1, i};
-    index_order[Tile::V][{face[Tile::V]}] = {-1, i};
-    index_order[Tile::E][{face[Tile::E]}] = {-1, i};
-    index_order[Tile::F][{face[Tile::F]}] = {-1, i};
-    store_tri(index_order[Tile::VE], make_edge(face[Tile::V], face[Tile::E]),
-              i);
-    index_order[Tile::EF][make_edge(face[Tile::E], face[Tile::F])] = {-1, i};
-    index_order[Tile::FV][make_edge(face[Tile::F], face[Tile::V])] = {-1, i};
-  }
-  for (int i = (int)Tile::V; i <= (int)Tile::VEF; i++) {
-    int pos = 0;
-    for (auto &m : index_order[i])
-      m.second.first = pos++;
-  }
+  vector<vector<int>> elem_orders;
+  vector<vector<int>> example_tris;
+  find_element_orders(meta, elem_orders, example_tris);
 
   // Starting offset of vertices corresponding to each pattern point
   vector<int> point_vertex_offsets(points.size());
@@ -659,8 +705,7 @@ Status Tiling::make_tiling(Geometry &geom,
     int incl = pt.get_inclusion();
     Vec3d crds = pt.get_coords();
     crds /= crds[0] + crds[1] + crds[2];
-    for (auto &m : index_order[incl]) {
-      const int f_idx = m.second.second;
+    for (int f_idx : example_tris[incl]) {
       Color col = coloring.get_point_color(pt);
       if (coloring.is_associated_element(TilingColoring::POINTS))
         col = get_associated_element_point_color(f_idx, incl);
@@ -668,6 +713,8 @@ Status Tiling::make_tiling(Geometry &geom,
     }
   }
 
+  ThreadPool pool(num_threads);
+  const int num_parts = pool.get_num_threads();
   int faces_sz = meta.faces().size();
   for (unsigned int p_idx = 0; p_idx < pat_paths.size(); p_idx++) {
     const auto &pat = pat_paths[p_idx];
@@ -681,12 +728,71 @@ Status Tiling::make_tiling(Geometry &geom,
       return Status::error(msg.c_str());
     }
 
+    vector<int> starts;
+    unsigned char start_faces = pat.get_start_faces();
+    for (int i = 0; i < faces_sz; i++) {
+      if (valid_start_face(i, start_faces)) {
+        starts.push_back(i);
+        if (one_of_each_tile)
+          break;
+      }
+    }
+
+    // Find circuits for consecutive ranges of start triangles in
+    // parallel, each part skipping the triangles used by its own circuits
+    const int starts_sz = starts.size();
+    vector<vector<Circuit>> part_circuits(num_parts);
+    auto find_part_circuits = [&](int part) {
+      Tile part_pat = pat; // the tile holds its current operation
+      vector<bool> part_seen(faces_sz, false);
+      const int end = part_start(starts_sz, num_parts, part + 1);
+      for (int j = part_start(starts_sz, num_parts, part); j < end; j++) {
+        if (!part_seen[starts[j]]) {
+          Circuit circuit;
+          circuit.start = starts[j];
+          circuit.complete =
+              find_circuit(starts[j], part_pat, elem_orders,
+                           point_vertex_offsets, circuit.face, circuit.tris);
+          for (int tri : circuit.tris)
+            part_seen[tri] = true;
+          part_circuits[part].push_back(std::move(circuit));
+        }
+      }
+    };
+    if (num_parts == 1)
+      find_part_circuits(0);
+    else
+      pool.run(num_parts, find_part_circuits);
+
+    // Add the circuits in start triangle order, skipping triangles used
+    // by earlier circuits, and finding any circuit that a part skipped
+    // because of a circuit that is not used
     auto assoc = pat.get_element_association();
     vector<bool> seen(faces_sz, false);
     int start_faces_sz = geom.faces().size();
-    unsigned char start_faces = pat.get_start_faces();
-    for (int i = 0; i < faces_sz; i++) {
-      if (!seen[i] && valid_start_face(i, start_faces)) {
+    Circuit found;
+    for (int part = 0; part < num_parts; part++) {
+      auto circuit_it = part_circuits[part].cbegin();
+      const int end = part_start(starts_sz, num_parts, part + 1);
+      for (int j = part_start(starts_sz, num_parts, part); j < end; j++) {
+        const int i = starts[j];
+        const Circuit *circuit = nullptr;
+        if (circuit_it != part_circuits[part].cend() &&
+            circuit_it->start == i)
+          circuit = &*circuit_it++;
+        if (seen[i])
+          continue;
+        if (!circuit) {
+          found.complete = find_circuit(i, pat, elem_orders,
+                                        point_vertex_offsets, found.face,
+                                        found.tris);
+          circuit = &found;
+        }
+        for (int tri : circuit->tris)
+          seen[tri] = true;
+        if (!circuit->complete)
+          continue;
+
         Color col; // col_type==ColoringType::none
         if (coloring.is_index(TilingColoring::TILES))
           col.set_index(p_idx);
@@ -703,9 +809,7 @@ Status Tiling::make_tiling(Geometry &geom,
               col = orig_colors.get(col_idx);
           }
         }
-        add_circuit(geom, i, pat, seen, col, index_order, point_vertex_offsets);
-        if (one_of_each_tile)
-          break;
+        geom.add_face(circuit->face, col);
       }
     }
     if (tile_reports) {
@@ -714,6 +818,9 @@ Status Tiling::make_tiling(Geometry &geom,
     }
   }
 
+  if (merge_doubled) // some tiles may be doubled
+    delete_doubled_faces(geom);
+
   delete_verts(geom, geom.get_info().get_free_verts());
   return Status::ok();
 }
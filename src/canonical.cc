@@ -428,6 +428,11 @@ Options
   -l <lim>  minimum distance change to terminate, as negative exponent
                (default: %d giving %.0e)
             WARNING: high values can cause non-terminal behaviour. Use -n
+  -A <num>  accelerate convergence by mixing in the changes from this
+            number of previous iterations (Anderson acceleration), 0 for
+            no acceleration (default: %d)
+  -j <thds> number of threads to use for canonicalization (-c c, -c m) and
+            finding symmetry, 0 for the number of processors (default: %d)
   -o <file> write output to file (default: write to standard output)
 
 Canonical and Planarization Options
@@ -506,7 +511,9 @@ keyword: none - sets no color, u - input base model, color of element unchanged
 )",
       prog_name(), help_ver_text, it_ctrl.get_status_check_and_report_iters(),
       it_ctrl.get_status_check_only_iters(), it_ctrl.get_sig_digits(),
-      it_ctrl.get_test_val(), it_ctrl.get_max_iters(), it_ctrl.get_max_iters());
+      it_ctrl.get_test_val(), it_ctrl.get_accel_depth(),
+      it_ctrl.get_num_threads(), it_ctrl.get_max_iters(),
+      it_ctrl.get_max_iters());
 }
 
 void cn_opts::process_command_line(int argc, char **argv)
@@ -542,7 +549,7 @@ void cn_opts::process_command_line(int argc, char **argv)
   handle_long_opts(argc, argv);
 
   while ((c = getopt(argc, argv,
-                     ":hHe:s:t:p:i:c:n:yO:q:g:Q:P:f:Cd:Yz:V:E:F:m:l:o:")) !=
+                     ":hHe:s:t:p:i:c:n:yO:q:g:Q:P:f:Cd:Yz:V:E:F:m:l:A:j:o:")) !=
          -1) {
     if (common_opts(c, optopt))
       continue;
@@ -702,6 +709,16 @@ void cn_opts::process_command_line(int argc, char **argv)
       print_status_or_exit(it_ctrl.set_sig_digits(num), c);
       break;
 
+    case 'A':
+      print_status_or_exit(read_int(optarg, &num), c);
+      print_status_or_exit(it_ctrl.set_accel_depth(num), c);
+      break;
+
+    case 'j':
+      print_status_or_exit(read_int(optarg, &num), c);
+      print_status_or_exit(it_ctrl.set_num_threads(num), c);
+      break;
+
     case 'o':
       ofile = optarg;
       break;
@@ -1743,20 +1760,73 @@ bool canonicalize_mm(Geometry &geom, IterationControl it_ctrl,
   vector<vector<int>> edges;
   geom.get_impl_edges(edges);
 
+  // Faces to make planar (not triangles), and the faces that each vertex
+  // lies on, in face order, so that each vertex can gather its own
+  // adjustments, in the same order as they were made face by face
+  const vector<vector<int>> &faces = geom.faces();
+  vector<int> plane_faces;
+  vector<vector<int>> vert_faces(verts.size());
+  for (unsigned int f = 0; f < faces.size(); f++) {
+    if (faces[f].size() == 3)
+      continue;
+    plane_faces.push_back(f);
+    for (int v : faces[f])
+      vert_faces[v].push_back(f);
+  }
+
+  // With more than one thread the edge adjustments are all made from the
+  // vertex positions at the start of the iteration, rather than in turn,
+  // with each vertex gathering its adjustments in edge order
+  ThreadPool pool(it_ctrl.get_num_threads());
+  const int num_parts = pool.get_num_threads();
+  vector<vector<int>> vert_edges;
+  if (num_parts > 1) {
+    vert_edges.resize(verts.size());
+    for (unsigned int e = 0; e < edges.size(); e++)
+      for (int v : edges[e])
+        vert_edges[v].push_back(e);
+  }
+
+  vector<Vec3d> verts_last(verts.size());
+  vector<Vec3d> near_pts(edges.size());
+  vector<Vec3d> edge_offsets(edges.size());
+  vector<Vec3d> norms(faces.size()); // face normals, pointing outwards
+  vector<Vec3d> cents(faces.size()); // face centroids
+
   double test_val = it_ctrl.get_test_val();
   double max_diff2 = 0;
+  AndersonAccel accel(it_ctrl.get_accel_depth());
 
   for (it_ctrl.start_iter(); !it_ctrl.is_done(); it_ctrl.next_iter()) {
-    vector<Vec3d> verts_last = verts;
+    std::copy(verts.begin(), verts.end(), verts_last.begin());
 
     if (!planarize_only) {
-      vector<Vec3d> near_pts;
-      for (auto &edge : edges) {
-        Vec3d P = geom.edge_nearpt(edge, Vec3d::zero);
-        near_pts.push_back(P);
-        Vec3d offset = edge_factor * (P.len() - 1) * P;
-        verts[edge[0]] -= offset;
-        verts[edge[1]] -= offset;
+      if (num_parts > 1) {
+        const int e_sz = edges.size();
+        pool.run(num_parts, [&](int part) {
+          const int end = part_start(e_sz, num_parts, part + 1);
+          for (int e = part_start(e_sz, num_parts, part); e < end; e++) {
+            near_pts[e] = geom.edge_nearpt(edges[e], Vec3d::zero);
+            edge_offsets[e] = edge_factor * (near_pts[e].len() - 1) *
+                              near_pts[e];
+          }
+        });
+        const int v_sz = verts.size();
+        pool.run(num_parts, [&](int part) {
+          const int end = part_start(v_sz, num_parts, part + 1);
+          for (int v = part_start(v_sz, num_parts, part); v < end; v++)
+            for (int e : vert_edges[v])
+              verts[v] -= edge_offsets[e];
+        });
+      }
+      else {
+        for (unsigned int e = 0; e < edges.size(); e++) {
+          Vec3d P = geom.edge_nearpt(edges[e], Vec3d::zero);
+          near_pts[e] = P;
+          Vec3d offset = edge_factor * (P.len() - 1) * P;
+          verts[edges[e][0]] -= offset;
+          verts[edges[e][1]] -= offset;
+        }
       }
 
       // re-center for drift
@@ -1765,32 +1835,37 @@ bool canonicalize_mm(Geometry &geom, IterationControl it_ctrl,
         verts[i] -= cent_near_pts;
     }
 
-    // Make a copy of verts into vs and zero out
+    const int pf_sz = plane_faces.size();
+    pool.run(num_parts, [&](int part) {
+      const int end = part_start(pf_sz, num_parts, part + 1);
+      for (int i = part_start(pf_sz, num_parts, part); i < end; i++) {
+        const int f = plane_faces[i];
+        Vec3d face_normal = face_norm(geom.verts(), faces[f]).unit();
+        Vec3d face_centroid = geom.face_cent(f);
+        // make sure face_normal points outward
+        if (vdot(face_normal, face_centroid) < 0)
+          face_normal *= -1.0;
+        norms[f] = face_normal;
+        cents[f] = face_centroid;
+      }
+    });
+
     // Accumulate vertex changes instead of altering vertices in place
     // This can help relieve when a vertex is pushed towards one plane
     // and away from another
-    vector<Vec3d> vs = verts;
-    for (auto &v : vs)
-      v = Vec3d::zero;
-
-    for (unsigned int f = 0; f < geom.faces().size(); f++) {
-      if (geom.faces(f).size() == 3)
-        continue;
-      Vec3d face_normal = face_norm(geom.verts(), geom.faces(f)).unit();
-      Vec3d face_centroid = geom.face_cent(f);
-      // make sure face_normal points outward
-      if (vdot(face_normal, face_centroid) < 0)
-        face_normal *= -1.0;
-      // place a planar vertex over or under verts[v]
-      // adds or subtracts it to get to the planar verts[v]
-      for (int v : geom.faces(f))
-        vs[v] += vdot(plane_factor * face_normal, face_centroid - verts[v]) *
-                 face_normal;
-    }
-
-    // adjust vertices post-loop
-    for (unsigned int i = 0; i < vs.size(); i++)
-      verts[i] += vs[i];
+    const int v_sz = verts.size();
+    pool.run(num_parts, [&](int part) {
+      const int end = part_start(v_sz, num_parts, part + 1);
+      for (int v = part_start(v_sz, num_parts, part); v < end; v++) {
+        // place a planar vertex over or under verts[v]
+        // adds or subtracts it to get to the planar verts[v]
+        Vec3d offset = Vec3d::zero;
+        for (int f : vert_faces[v])
+          offset += vdot(plane_factor * norms[f], cents[f] - verts[v]) *
+                    norms[f];
+        verts[v] += offset;
+      }
+    });
 
     string finish_msg;
     if (it_ctrl.is_status_check_iter()) {
@@ -1832,6 +1907,10 @@ bool canonicalize_mm(Geometry &geom, IterationControl it_ctrl,
       it_ctrl.print("%-12u max_diff:%17.15e\n", it_ctrl.get_current_iter(),
                     sqrt(max_diff2));
     }
+
+    // the test value is from the plain iteration, accelerate afterwards
+    if (!it_ctrl.is_finished())
+      accel.update(verts_last, verts);
   }
 
   return completed;
@@ -1864,6 +1943,7 @@ bool canonicalize_unit(Geometry &geom, IterationControl it_ctrl,
 
   double test_val = it_ctrl.get_test_val();
   double max_diff2 = 0;
+  AndersonAccel accel(it_ctrl.get_accel_depth());
 
   for (it_ctrl.start_iter(); !it_ctrl.is_done(); it_ctrl.next_iter()) {
     vector<Vec3d> verts_last = verts;
@@ -1953,6 +2033,10 @@ bool canonicalize_unit(Geometry &geom, IterationControl it_ctrl,
       it_ctrl.print("%-12u max_diff:%17.15e\n", it_ctrl.get_current_iter(),
                     sqrt(max_diff2));
     }
+
+    // the test value is from the plain iteration, accelerate afterwards
+    if (!it_ctrl.is_finished())
+      accel.update(verts_last, verts);
   }
 
   return completed;
@@ -1969,7 +2053,7 @@ bool planarize_unit(Geometry &geom, IterationControl it_ctrl)
 
 void realign_output(Geometry &base, const cn_opts &opts)
 {
-  Symmetry sym(base);
+  Symmetry sym(base, nullptr, opts.it_ctrl.get_num_threads());
   opts.message(msg_str("the symmetry of output model is %s (realigned)\n",
                        sym.get_symbol().c_str()));
   base.transform(sym.get_to_std());
@@ -2002,7 +2086,8 @@ int main(int argc, char *argv[])
 
   Symmetry sym;
   if (opts.use_symmetry) {
-    opts.print_status_or_exit(sym.init(base), 'y');
+    opts.print_status_or_exit(
+        sym.init(base, nullptr, opts.it_ctrl.get_num_threads()), 'y');
     // find the nearest point to the origin in the subspace fixed by sym
     // the distance of this point from the origin should be within the
     // precision limit, or the canonical algorithm may not complete
@@ -283,6 +283,7 @@ bool canonicalize_bd(Geometry &base, IterationControl it_ctrl,
 
   double test_val = it_ctrl.get_test_val();
   double max_diff2 = 0;
+  AndersonAccel accel(it_ctrl.get_accel_depth());
 
   for (it_ctrl.start_iter(); !it_ctrl.is_done(); it_ctrl.next_iter()) {
     vector<Vec3d> base_verts_last = base.verts();
@@ -353,6 +354,10 @@ bool canonicalize_bd(Geometry &base, IterationControl it_ctrl,
       it_ctrl.print("%-12u max_diff:%17.15e\n", it_ctrl.get_current_iter(),
                     sqrt(max_diff2));
     }
+
+    // the test value is from the plain iteration, accelerate afterwards
+    if (!it_ctrl.is_finished())
+      accel.update(base_verts_last, base.raw_verts());
   }
 
   return completed;
@@ -437,6 +437,7 @@ void color_faces_by_connection(Geometry &geom, Coloring &clrng, bool apply_map)
   // transfer edge and vertex colors from geom
   // if elements were invisible, mark them maximum
   // only non-counted element will remain invisible
+  VertIndex geom_vert_idx(geom, anti::epsilon);
   for (unsigned int i = 0; i < kis.edges().size(); i++) {
     unsigned int v_idx[2];
     Vec3d v[2];
@@ -444,7 +445,7 @@ void color_faces_by_connection(Geometry &geom, Coloring &clrng, bool apply_map)
       v_idx[j] = kis.edges(i)[j];
       v[j] = kis.verts(v_idx[j]);
     }
-    int geom_edge_no = find_edge_by_coords(geom, v[0], v[1], anti::epsilon);
+    int geom_edge_no = find_edge_by_coords(geom, geom_vert_idx, v[0], v[1]);
     Color col;
     if (geom_edge_no > -1) {
       col = geom.colors(EDGES).get(geom_edge_no);
@@ -456,8 +457,7 @@ void color_faces_by_connection(Geometry &geom, Coloring &clrng, bool apply_map)
     }
     for (unsigned int j = 0; j < 2; j++) {
       int ev = kis.edges(i)[j];
-      int geom_v_idx =
-          find_vert_by_coords(geom, kis.verts()[ev], anti::epsilon);
+      int geom_v_idx = geom_vert_idx.find(kis.verts()[ev]);
       if (geom_v_idx > -1) {
         col = geom.colors(VERTS).get(geom_v_idx);
         if (col.is_invisible())
@@ -531,6 +531,7 @@ Status color_faces_by_connection_vef(Geometry &geom, OffColor &off_color)
 
   // reassert invisible elements from kis operation
   if (op && strchr("hH", op)) {
+    VertIndex save_vert_idx(geom_save, anti::epsilon);
     for (unsigned int i = 0; i < geom.edges().size(); i++) {
       unsigned int v_idx[2];
       Vec3d v[2];
@@ -540,7 +541,7 @@ Status color_faces_by_connection_vef(Geometry &geom, OffColor &off_color)
       }
       Color col;
       int save_edge_no =
-          find_edge_by_coords(geom_save, v[0], v[1], anti::epsilon);
+          find_edge_by_coords(geom_save, save_vert_idx, v[0], v[1]);
       if (save_edge_no > -1) {
         col = geom_save.colors(EDGES).get(save_edge_no);
         if (col.is_invisible())
@@ -548,8 +549,7 @@ Status color_faces_by_connection_vef(Geometry &geom, OffColor &off_color)
       }
       for (unsigned int j = 0; j < 2; j++) {
         int ev = geom.edges(i)[j];
-        int save_idx =
-            find_vert_by_coords(geom_save, geom.verts()[ev], anti::epsilon);
+        int save_idx = save_vert_idx.find(geom.verts()[ev]);
         col = geom_save.colors(VERTS).get(save_idx);
         if (col.is_invisible())
           geom.colors(VERTS).set(ev, col);
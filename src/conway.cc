@@ -35,8 +35,11 @@
 #include "canonical_common.h"
 #include "color_common.h"
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 using std::pair;
@@ -1255,6 +1258,9 @@ Conway Notation Options
               x - none
   -i <itrs> maximum planarize iterations. -1 for unlimited (default: %d)
             WARNING: unstable models may not finish unless -i is set
+  -A <num>  accelerate convergence by mixing in the changes from this
+            number of previous iterations (Anderson acceleration), 0 for
+            no acceleration (default: %d)
 
 Coloring Options (run 'off_util -H color' for help on color formats)
 keyword: none - sets no color
@@ -1296,6 +1302,7 @@ keyword: none - sets no color
           it_ctrl.get_status_check_and_report_iters(),
           it_ctrl.get_status_check_only_iters(), it_ctrl.get_sig_digits(),
           it_ctrl.get_test_val(), it_ctrl.get_max_iters(),
+          it_ctrl.get_accel_depth(),
           TilingColoring::get_option_help('C').c_str());
 }
 
@@ -1316,7 +1323,8 @@ void cn_opts::process_command_line(int argc, char **argv)
 
   handle_long_opts(argc, argv);
 
-  while ((c = getopt(argc, argv, ":hHsgtruvc:p:l:i:z:C:V:E:F:T:m:o:")) != -1) {
+  while ((c = getopt(argc, argv, ":hHsgtruvc:p:l:i:A:z:C:V:E:F:T:m:o:")) !=
+         -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -1435,6 +1443,11 @@ void cn_opts::process_command_line(int argc, char **argv)
       print_status_or_exit(it_ctrl.set_max_iters(num), c);
       break;
 
+    case 'A':
+      print_status_or_exit(read_int(optarg, &num), c);
+      print_status_or_exit(it_ctrl.set_accel_depth(num), c);
+      break;
+
     case 'z':
       print_status_or_exit(it_ctrl.set_status_checks(optarg), c);
       break;
@@ -1872,29 +1885,156 @@ void get_seed(Geometry &geom, cn_opts &opts)
 }
 
 // RK - for hart code
-void build_new_faces(map<string, map<string, string>> &faces_table,
-                     map<string, int> verts_table,
-                     vector<vector<int>> &faces_new)
+// The element names of George Hart's string tables, e.g. "f3" or "2_5",
+// are packed into integers. The string forms are only made to order the
+// faces, and choose the starting vertex of each face, as the original
+// string keyed maps did, so the output is unchanged.
+enum {
+  hart_edge,       // "v1_v2", v1 < v2
+  hart_face,       // "f<num>"
+  hart_vert,       // "v<num>"
+  hart_dir_edge,   // "v1~v2"
+  hart_face_corner // "<f_num>f<v_num>"
+};
+
+static inline unsigned long long hart_name(int type, int a, int b = 0)
+{
+  return ((unsigned long long)type << 60) | ((unsigned long long)a << 30) |
+         (unsigned long long)b;
+}
+
+static void hart_name_str(unsigned long long name, char *buf)
+{
+  const int type = name >> 60;
+  const int a = (name >> 30) & 0x3fffffff;
+  const int b = name & 0x3fffffff;
+  if (type == hart_edge)
+    sprintf(buf, "%d_%d", a, b);
+  else if (type == hart_face)
+    sprintf(buf, "f%d", a);
+  else if (type == hart_vert)
+    sprintf(buf, "v%d", a);
+  else if (type == hart_dir_edge)
+    sprintf(buf, "%d~%d", a, b);
+  else
+    sprintf(buf, "%df%d", a, b);
+}
+
+// Vertex and face tables for the hart_ operators. Each new face is a
+// cycle of vertex names, given as a table of the next name in the face.
+class HartTables {
+private:
+  struct Entry {
+    int face;                // face number
+    unsigned long long key;  // vertex name
+    unsigned long long next; // name of next vertex in face
+  };
+
+  std::unordered_map<unsigned long long, int> verts_table;
+  std::unordered_map<unsigned long long, int> face_nums;
+  vector<unsigned long long> face_names;
+  vector<Entry> entries;
+
+public:
+  // Set the new vertex index number for a vertex name
+  void set_vert(unsigned long long name, int v_idx)
+  {
+    verts_table[name] = v_idx;
+  }
+
+  // Set the next vertex name after a vertex name in a face
+  void set_next(unsigned long long face_name, unsigned long long key,
+                unsigned long long next)
+  {
+    auto fi = face_nums.insert(std::make_pair(face_name, face_names.size()));
+    if (fi.second)
+      face_names.push_back(face_name);
+    entries.push_back({fi.first->second, key, next});
+  }
+
+  // Make the faces, in face name order, each starting with the vertex
+  // after the lowest vertex name in the face
+  void build_new_faces(vector<vector<int>> &faces_new);
+};
+
+void HartTables::build_new_faces(vector<vector<int>> &faces_new)
 {
-  map<string, map<string, string>>::iterator ft;
-  map<string, string>::iterator ftm;
-  string face_name;
-  for (ft = faces_table.begin(); ft != faces_table.end(); ft++) {
-    for (ftm = ft->second.begin(); ftm != ft->second.end(); ftm++) {
-      if (face_name != ft->first) {
-        face_name = ft->first;
-        string v0 = faces_table[face_name][ftm->first];
-        string v = v0;
-        vector<int> face;
-        do {
-          face.push_back(verts_table[v]);
-          v = faces_table[face_name][v];
-        } while (v != v0);
-        if (face.size() > 2) // make sure face is valid
-          faces_new.push_back(face);
-        face.clear();
+  // group the entries by face, and then by key, where a key is set more
+  // than once the last setting is kept
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](const Entry &e0, const Entry &e1) {
+                     return (e0.face != e1.face) ? e0.face < e1.face
+                                                 : e0.key < e1.key;
+                   });
+  vector<Entry> ents;
+  ents.reserve(entries.size());
+  for (unsigned int i = 0; i < entries.size(); i++) {
+    if (i + 1 < entries.size() && entries[i].face == entries[i + 1].face &&
+        entries[i].key == entries[i + 1].key)
+      continue;
+    ents.push_back(entries[i]);
+  }
+  entries.clear();
+
+  vector<int> face_starts(face_names.size() + 1, ents.size());
+  for (int i = ents.size() - 1; i >= 0; i--)
+    face_starts[ents[i].face] = i;
+
+  // the faces are ordered by name string, each formatted once
+  vector<string> face_strs(face_names.size());
+  char buf[32];
+  for (unsigned int i = 0; i < face_names.size(); i++) {
+    hart_name_str(face_names[i], buf);
+    face_strs[i] = buf;
+  }
+  vector<int> face_order(face_names.size());
+  for (unsigned int i = 0; i < face_order.size(); i++)
+    face_order[i] = i;
+  std::sort(face_order.begin(), face_order.end(),
+            [&](int f0, int f1) { return face_strs[f0] < face_strs[f1]; });
+  face_strs.clear();
+
+  auto get_vert = [&](unsigned long long name) {
+    auto vi = verts_table.find(name);
+    return (vi != verts_table.end()) ? vi->second : 0;
+  };
+
+  for (int f : face_order) {
+    const auto f_begin = ents.begin() + face_starts[f];
+    const auto f_end = ents.begin() + face_starts[f + 1];
+    auto find_next = [&](unsigned long long key) {
+      auto ei = std::lower_bound(
+          f_begin, f_end, key,
+          [](const Entry &e, unsigned long long k) { return e.key < k; });
+      return (ei != f_end && ei->key == key) ? ei : f_end;
+    };
+
+    // lowest key name string, each key formatted once
+    auto first = f_begin;
+    char first_buf[32];
+    hart_name_str(first->key, first_buf);
+    for (auto ei = f_begin + 1; ei < f_end; ++ei) {
+      hart_name_str(ei->key, buf);
+      if (strcmp(buf, first_buf) < 0) {
+        first = ei;
+        strcpy(first_buf, buf);
       }
     }
+
+    const unsigned long long v0 = first->next;
+    unsigned long long v = v0;
+    vector<int> face;
+    do {
+      face.push_back(get_vert(v));
+      auto ei = find_next(v);
+      if (ei == f_end || (int)face.size() > f_end - f_begin) {
+        face.clear(); // the vertex names do not form a cycle
+        break;
+      }
+      v = ei->next;
+    } while (v != v0);
+    if (face.size() > 2) // make sure face is valid
+      faces_new.push_back(face);
   }
 }
 
@@ -1904,37 +2044,26 @@ void hart_ambo(Geometry &geom)
   vector<vector<int>> &faces = geom.raw_faces();
   vector<Vec3d> &verts = geom.raw_verts();
 
-  map<string, int> verts_table;
-  map<string, map<string, string>> faces_table;
+  HartTables tables;
   vector<Vec3d> verts_new;
 
-  string buf1;
-  string buf2;
-  string buf3;
+  const int f_sz = faces.size();
   unsigned int vert_num = 0;
-  for (unsigned int i = 0; i < faces.size(); i++) {
+  for (int i = 0; i < f_sz; i++) {
     int v1 = faces[i].at(faces[i].size() - 2);
     int v2 = faces[i].at(faces[i].size() - 1);
     for (unsigned int j = 0; j < faces[i].size(); j++) {
       int v3 = faces[i].at(j);
       if (v1 < v2) {
-        buf1 = std::to_string((v1 < v2) ? v1 : v2) + "_" +
-               std::to_string((v1 > v2) ? v1 : v2);
-        verts_table[buf1] = vert_num++;
+        tables.set_vert(hart_name(hart_edge, v1, v2), vert_num++);
         verts_new.push_back((verts[v1] + verts[v2]) * 0.5);
       }
-      buf1 = "f" + std::to_string(i);
-      buf2 = std::to_string((v1 < v2) ? v1 : v2) + "_" +
-             std::to_string((v1 > v2) ? v1 : v2);
-      buf3 = std::to_string((v2 < v3) ? v2 : v3) + "_" +
-             std::to_string((v2 > v3) ? v2 : v3);
-      faces_table[buf1][buf2] = buf3;
-      buf1 = "v" + std::to_string(v2);
-      buf2 = std::to_string((v2 < v3) ? v2 : v3) + "_" +
-             std::to_string((v2 > v3) ? v2 : v3);
-      buf3 = std::to_string((v1 < v2) ? v1 : v2) + "_" +
-             std::to_string((v1 > v2) ? v1 : v2);
-      faces_table[buf1][buf2] = buf3;
+      const unsigned long long e12 =
+          hart_name(hart_edge, std::min(v1, v2), std::max(v1, v2));
+      const unsigned long long e23 =
+          hart_name(hart_edge, std::min(v2, v3), std::max(v2, v3));
+      tables.set_next(hart_name(hart_face, i), e12, e23);
+      tables.set_next(hart_name(hart_vert, v2), e23, e12);
       v1 = v2;
       v2 = v3;
     }
@@ -1944,9 +2073,7 @@ void hart_ambo(Geometry &geom)
   verts = verts_new;
   verts_new.clear();
 
-  build_new_faces(faces_table, verts_table, faces);
-  faces_table.clear();
-  verts_table.clear();
+  tables.build_new_faces(faces);
 }
 
 void hart_gyro(Geometry &geom)
@@ -1954,26 +2081,20 @@ void hart_gyro(Geometry &geom)
   vector<vector<int>> &faces = geom.raw_faces();
   vector<Vec3d> &verts = geom.raw_verts();
 
-  map<string, int> verts_table;
-  map<string, map<string, string>> faces_table;
+  HartTables tables;
   vector<Vec3d> verts_new;
 
-  string buf1;
-  string buf2;
-  string buf3;
   unsigned int vert_num = 0;
   vector<Vec3d> centers;
   geom.face_cents(centers);
   for (unsigned int i = 0; i < faces.size(); i++) {
-    buf1 = "f" + std::to_string(i);
-    verts_table[buf1] = vert_num++;
+    tables.set_vert(hart_name(hart_face, i), vert_num++);
     verts_new.push_back(centers[i].unit());
   }
   centers.clear();
 
   for (unsigned int i = 0; i < verts.size(); i++) {
-    buf1 = "v" + std::to_string(i);
-    verts_table[buf1] = vert_num++;
+    tables.set_vert(hart_name(hart_vert, i), vert_num++);
     verts_new.push_back(verts[i]);
   }
 
@@ -1982,27 +2103,19 @@ void hart_gyro(Geometry &geom)
     int v2 = faces[i].at(faces[i].size() - 1);
     for (unsigned int j = 0; j < faces[i].size(); j++) {
       int v3 = faces[i].at(j);
-      buf1 = std::to_string(v1) + "~" + std::to_string(v2);
-      verts_table[buf1] = vert_num++;
+      const unsigned long long e12 = hart_name(hart_dir_edge, v1, v2);
+      const unsigned long long e21 = hart_name(hart_dir_edge, v2, v1);
+      const unsigned long long e23 = hart_name(hart_dir_edge, v2, v3);
+      tables.set_vert(e12, vert_num++);
       // approx. (2/3)v1 + (1/3)v2
       verts_new.push_back(verts[v1] * 0.7 + verts[v2] * 0.3);
 
-      buf1 = std::to_string(i) + "f" + std::to_string(v1);
-      buf2 = "f" + std::to_string(i);
-      buf3 = std::to_string(v1) + "~" + std::to_string(v2);
-      faces_table[buf1][buf2] = buf3;
-      buf2 = std::to_string(v1) + "~" + std::to_string(v2);
-      buf3 = std::to_string(v2) + "~" + std::to_string(v1);
-      faces_table[buf1][buf2] = buf3;
-      buf2 = std::to_string(v2) + "~" + std::to_string(v1);
-      buf3 = "v" + std::to_string(v2);
-      faces_table[buf1][buf2] = buf3;
-      buf2 = "v" + std::to_string(v2);
-      buf3 = std::to_string(v2) + "~" + std::to_string(v3);
-      faces_table[buf1][buf2] = buf3;
-      buf2 = std::to_string(v2) + "~" + std::to_string(v3);
-      buf3 = "f" + std::to_string(i);
-      faces_table[buf1][buf2] = buf3;
+      const unsigned long long face = hart_name(hart_face_corner, i, v1);
+      tables.set_next(face, hart_name(hart_face, i), e12);
+      tables.set_next(face, e12, e21);
+      tables.set_next(face, e21, hart_name(hart_vert, v2));
+      tables.set_next(face, hart_name(hart_vert, v2), e23);
+      tables.set_next(face, e23, hart_name(hart_face, i));
 
       v1 = v2;
       v2 = v3;
@@ -2013,9 +2126,7 @@ void hart_gyro(Geometry &geom)
   verts = verts_new;
   verts_new.clear();
 
-  build_new_faces(faces_table, verts_table, faces);
-  faces_table.clear();
-  verts_table.clear();
+  tables.build_new_faces(faces);
 }
 
 void hart_kisN(Geometry &geom, int n)
@@ -2067,17 +2178,12 @@ void hart_propellor(Geometry &geom)
   vector<vector<int>> &faces = geom.raw_faces();
   vector<Vec3d> &verts = geom.raw_verts();
 
-  map<string, int> verts_table;
-  map<string, map<string, string>> faces_table;
+  HartTables tables;
   vector<Vec3d> verts_new;
 
-  string buf1;
-  string buf2;
-  string buf3;
   unsigned int vert_num = 0;
   for (unsigned int i = 0; i < verts.size(); i++) {
-    buf1 = "v" + std::to_string(i);
-    verts_table[buf1] = vert_num++;
+    tables.set_vert(hart_name(hart_vert, i), vert_num++);
     verts_new.push_back(verts[i].unit());
   }
 
@@ -2086,28 +2192,20 @@ void hart_propellor(Geometry &geom)
     int v2 = faces[i].at(faces[i].size() - 1);
     for (unsigned int j = 0; j < faces[i].size(); j++) {
       int v3 = faces[i].at(j);
-      buf1 = std::to_string(v1) + "~" + std::to_string(v2);
-      verts_table[buf1] = vert_num++;
+      const unsigned long long e12 = hart_name(hart_dir_edge, v1, v2);
+      const unsigned long long e21 = hart_name(hart_dir_edge, v2, v1);
+      const unsigned long long e23 = hart_name(hart_dir_edge, v2, v3);
+      tables.set_vert(e12, vert_num++);
       // approx. (2/3)v1 + (1/3)v2
       verts_new.push_back(verts[v1] * 0.7 + verts[v2] * 0.3);
 
-      buf1 = "v" + std::to_string(i);
-      buf2 = std::to_string(v1) + "~" + std::to_string(v2);
-      buf3 = std::to_string(v2) + "~" + std::to_string(v3);
-      faces_table[buf1][buf2] = buf3;
-      buf1 = std::to_string(i) + "f" + std::to_string(v2);
-      buf2 = std::to_string(v1) + "~" + std::to_string(v2);
-      buf3 = std::to_string(v2) + "~" + std::to_string(v1);
-      faces_table[buf1][buf2] = buf3;
-      buf2 = std::to_string(v2) + "~" + std::to_string(v1);
-      buf3 = "v" + std::to_string(v2);
-      faces_table[buf1][buf2] = buf3;
-      buf2 = "v" + std::to_string(v2);
-      buf3 = std::to_string(v2) + "~" + std::to_string(v3);
-      faces_table[buf1][buf2] = buf3;
-      buf2 = std::to_string(v2) + "~" + std::to_string(v3);
-      buf3 = std::to_string(v1) + "~" + std::to_string(v2);
-      faces_table[buf1][buf2] = buf3;
+      // the central face is named by the face number, as in the original
+      tables.set_next(hart_name(hart_vert, i), e12, e23);
+      const unsigned long long face = hart_name(hart_face_corner, i, v2);
+      tables.set_next(face, e12, e21);
+      tables.set_next(face, e21, hart_name(hart_vert, v2));
+      tables.set_next(face, hart_name(hart_vert, v2), e23);
+      tables.set_next(face, e23, e12);
 
       v1 = v2;
       v2 = v3;
@@ -2118,9 +2216,7 @@ void hart_propellor(Geometry &geom)
   verts = verts_new;
   verts_new.clear();
 
-  build_new_faces(faces_table, verts_table, faces);
-  faces_table.clear();
-  verts_table.clear();
+  tables.build_new_faces(faces);
 }
 
 /*
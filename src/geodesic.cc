@@ -51,6 +51,7 @@ public:
   char method;
   bool keep_flat;
   bool equal_len_div;
+  int num_threads = 1;
   string ifile;
   string ofile;
 
@@ -92,6 +93,8 @@ Options
                 surface of the original polyhedron.
   -C <cent> centre of points, in form \"x_val,y_val,z_val\" (default: 0,0,0)
             used for geodesic spheres
+  -j <thds> number of threads to use to fill the base faces, 0 for the
+            number of processors (default: 1)
   -o <file> write output to file (default: write to standard output)
 
 )",
@@ -105,7 +108,7 @@ void geo_opts::process_command_line(int argc, char **argv)
 
   handle_long_opts(argc, argv);
 
-  while ((c = getopt(argc, argv, ":hf:F:c:M:C:o:")) != -1) {
+  while ((c = getopt(argc, argv, ":hf:F:c:M:C:j:o:")) != -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -163,6 +166,12 @@ void geo_opts::process_command_line(int argc, char **argv)
               c);
       break;
 
+    case 'j':
+      print_status_or_exit(read_int(optarg, &num_threads), c);
+      if (num_threads < 0)
+        error("number of threads cannot be negative", c);
+      break;
+
     case 'o':
       ofile = optarg;
       break;
@@ -206,9 +215,10 @@ int main(int argc, char **argv)
 
   Geometry geo;
   if (opts.method == 's')
-    make_geodesic_sphere(geo, geom, opts.m, opts.n, opts.centre);
+    make_geodesic_sphere(geo, geom, opts.m, opts.n, opts.centre,
+                         opts.num_threads);
   else if (opts.method == 'p')
-    make_geodesic_planar(geo, geom, opts.m, opts.n);
+    make_geodesic_planar(geo, geom, opts.m, opts.n, opts.num_threads);
 
   opts.write_or_error(geo, opts.ofile);
 
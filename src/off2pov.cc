@@ -74,6 +74,15 @@ Options
 %s
   -O <type> output type, can be: 'a' all in one POV file (default),
             's' separate files, 'o' objects only, 't' template only
+  -y <sym>  write each set of elements repeated by a symmetry once, and
+            display it with the symmetry transformations, sym is 'full' for
+            the full symmetry of the model, or a symmetry in standard
+            alignment, e.g. Ih, D5v (the output is not always smaller
+            than without this option)
+  -M        write faces as a single mesh2, and vertices and edges as
+            spheres and cylinders, rather than display them with macros
+            (faster to parse for large models, disp_vertex, disp_edge and
+            disp_face are not used)
   -i <fils> include files (separated by commas) for every POV geometry
   -j <fils> include files (separated by commas) for the POV scene file
   -J <fils> include files (separated by commas) containing additional POV
@@ -105,9 +114,9 @@ void o2p_opts::process_command_line(int argc, char **argv)
 
   handle_long_opts(argc, argv);
 
-  while ((c = getopt(argc, argv,
-                     ":hv:e:V:E:F:m:x:s:n:o:D:C:L:R:P:W:S:B:d:t:I:j:J:i:O:")) !=
-         -1) {
+  const char *optstr =
+      ":hv:e:V:E:F:m:x:s:n:o:D:C:L:R:P:W:S:B:d:t:I:j:J:i:O:y:M";
+  while ((c = getopt(argc, argv, optstr)) != -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -120,6 +129,10 @@ void o2p_opts::process_command_line(int argc, char **argv)
       shadow = true;
       break;
 
+    case 'M':
+      get_geom_defs().set_use_mesh(true);
+      break;
+
     case 'S':
       print_status_or_exit(read_int(optarg, &stereo_type), c);
       if (stereo_type < 0 || stereo_type > 3)
@@ -217,6 +230,7 @@ int main(int argc, char *argv[])
   }
 
   pov.write(ofile, scen, opts.sig_dgts);
+  opts.warn_instance_sym_unused(scen);
 
   if (opts.ofile != "")
     fclose(ofile);
@@ -63,6 +63,11 @@ Options
 %s
 %s
   -l        use lines for edges, points for vertices, in default colours
+  -y <sym>  write each set of elements repeated by the rotations of a
+            symmetry once, and display it with the rotations, sym is 'full'
+            for the full symmetry of the model, or a symmetry in standard
+            alignment, e.g. I, D5 (the output is not always smaller
+            than without this option)
   -o <file> write output to file (default: write to standard output)
 
   Scene options
@@ -85,7 +90,7 @@ void o2v_opts::process_command_line(int argc, char **argv)
   handle_long_opts(argc, argv);
 
   while ((c = getopt(argc, argv,
-                     ":hv:e:V:E:F:m:x:n:s:lo:D:C:L:R:P:I:B:d:t:")) != -1) {
+                     ":hv:e:V:E:F:m:x:n:s:lo:D:C:L:R:P:I:B:d:t:y:")) != -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -137,6 +142,7 @@ int main(int argc, char *argv[])
 
   VrmlWriter vrml;
   vrml.write(ofile, scen, opts.sig_dgts);
+  opts.warn_instance_sym_unused(scen);
 
   if (opts.ofile != "")
     fclose(ofile);
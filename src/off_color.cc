@@ -58,15 +58,14 @@ void color_vals_to_idxs(Geometry &geom, char elems = ELEM_ALL,
 
   map<Color, vector<vector<int>>> val2idxs;
   int first_idx = 0;
-  map<int, Color> *elem_cols[3] = {
-      (elems & ELEM_VERTS) ? &geom.colors(VERTS).get_properties() : nullptr,
-      (elems & ELEM_EDGES) ? &geom.colors(EDGES).get_properties() : nullptr,
-      (elems & ELEM_FACES) ? &geom.colors(FACES).get_properties() : nullptr};
+  ElemProps<Color> *elem_cols[3] = {
+      (elems & ELEM_VERTS) ? &geom.colors(VERTS) : nullptr,
+      (elems & ELEM_EDGES) ? &geom.colors(EDGES) : nullptr,
+      (elems & ELEM_FACES) ? &geom.colors(FACES) : nullptr};
   for (int i = 0; i < 3; i++) {
     if (elem_cols[i]) {
-      map<int, Color>::const_iterator mi;
-      for (mi = elem_cols[i]->begin(); mi != elem_cols[i]->end(); ++mi) {
-        const Color &col = mi->second;
+      for (const auto &kp : *elem_cols[i]) {
+        const Color &col = kp.second;
         if (col.is_index()) {
           if (col.get_index() > first_idx)
             first_idx = col.get_index() + 1;
@@ -80,7 +79,7 @@ void color_vals_to_idxs(Geometry &geom, char elems = ELEM_ALL,
             v2i_it = ins.first;
             v2i_it->second.resize(3);
           }
-          v2i_it->second[i].push_back(mi->first);
+          v2i_it->second[i].push_back(kp.first);
         }
       }
     }
@@ -93,7 +92,7 @@ void color_vals_to_idxs(Geometry &geom, char elems = ELEM_ALL,
     for (int i = 0; i < 3; i++)
       if (elem_cols[i])
         for (unsigned int j = 0; j < vmi->second[i].size(); j++)
-          (*elem_cols[i])[vmi->second[i][j]] = Color(idx_no);
+          elem_cols[i]->set(vmi->second[i][j], Color(idx_no));
     if (cmap)
       cmap->set_col(idx_no, vmi->first);
   }
@@ -667,11 +666,11 @@ int main(int argc, char *argv[])
 
   // value to value mappings
   if (opts.range_elems & (ELEM_VERTS))
-    opts.col_procs[0].apply(geom.colors(VERTS).get_properties());
+    opts.col_procs[0].apply(geom.colors(VERTS));
   if (opts.range_elems & (ELEM_EDGES))
-    opts.col_procs[1].apply(geom.colors(EDGES).get_properties());
+    opts.col_procs[1].apply(geom.colors(EDGES));
   if (opts.range_elems & (ELEM_FACES))
-    opts.col_procs[2].apply(geom.colors(FACES).get_properties());
+    opts.col_procs[2].apply(geom.colors(FACES));
 
   // Average colour values from adjoining elements after converting
   // index numbers
@@ -56,13 +56,14 @@ public:
   bool detect_symmetry;
   string sub_sym;
   char edge_type;
+  int num_threads;
   string ifile;
   string ofile;
 
   or_opts()
       : ProgramOpts("off_report"), center(Vec3d(0, 0, 0)),
         center_is_centroid(false), sig_digits(17), orient(true),
-        detect_symmetry(false), edge_type('a')
+        detect_symmetry(false), edge_type('a'), num_threads(1)
   {
   }
 
@@ -98,12 +99,14 @@ Options
             optionally followed by a comma and conjugation type (integer)
   -E <type> edges for report, e - explicit edges, i - implicit edges
             a - explicit and implicit (default)
+  -j <thds> number of threads to use for finding values of the elements
+            and the symmetry, 0 for the number of processors (default: %d)
   -o <file> write output to file (default: write to standard output)
   -d <dgts> number of significant digits (default 17) or if negative
             then the number of digits after the decimal point
 
 )",
-          prog_name(), help_ver_text);
+          prog_name(), help_ver_text, num_threads);
 }
 
 void or_opts::process_command_line(int argc, char **argv)
@@ -113,7 +116,7 @@ void or_opts::process_command_line(int argc, char **argv)
 
   handle_long_opts(argc, argv);
 
-  while ((c = getopt(argc, argv, ":hc:S:C:kE:y:o:d:")) != -1) {
+  while ((c = getopt(argc, argv, ":hc:S:C:kE:y:j:o:d:")) != -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -184,6 +187,12 @@ void or_opts::process_command_line(int argc, char **argv)
       edge_type = *optarg;
       break;
 
+    case 'j':
+      print_status_or_exit(read_int(optarg, &num_threads), c);
+      if (num_threads < 0)
+        error("number of threads cannot be negative", c);
+      break;
+
     case 'd':
       print_status_or_exit(read_int(optarg, &sig_digits), c);
       break;
@@ -308,6 +317,7 @@ int main(int argc, char *argv[])
   rep_printer rep(geom, ofile);
   rep.set_sig_dgts(opts.sig_digits);
   rep.set_center(opts.center);
+  rep.set_num_threads(opts.num_threads);
 
   if (opts.detect_symmetry && !rep.set_sub_symmetry(opts.sub_sym))
     opts.error(("could not set subsymmetry: " + opts.sub_sym).c_str(), 'y');
@@ -1846,8 +1846,9 @@ vector<int> find_end_points_vertex(const Geometry &geom,
   const vector<Vec3d> &verts = geom.verts();
 
   Geometry vgeom;
+  VertIndex vert_idx(vgeom, eps);
   for (int vert_indexe : vert_indexes)
-    vertex_into_geom(vgeom, verts[vert_indexe], Color::invisible, eps);
+    vertex_into_geom(vgeom, vert_idx, verts[vert_indexe], Color::invisible);
   vgeom.set_hull();
 
   const vector<Vec3d> &gverts = vgeom.verts();
@@ -667,7 +667,7 @@ int main(int argc, char *argv[])
   if (opts.extra_ideal_elems)
     add_extra_ideal_elems(dual, center, 1.005 * opts.inf);
 
-  for (const auto &kv : dual.colors(FACES).get_properties())
+  for (const auto &kv : dual.colors(FACES))
     if (kv.second.is_invisible()) {
       opts.warning("dual includes invisible faces (base model included "
                    "invisible vertices)");
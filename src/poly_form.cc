@@ -110,6 +110,11 @@ Options
             gives the power)
   -l <lim>  minimum change of distance/width_of_model to terminate, as 
                negative exponent (default: %d giving %.0e)
+  -A <num>  accelerate convergence by mixing in the changes from this
+            number of previous iterations (Anderson acceleration), 0 for
+            no acceleration (default: %d)
+  -j <thds> number of threads to use for finding symmetry (-y), 0 for the
+            number of processors (default: %d)
   -z <nums> number of iterations between status reports (implies termination
             check) (0 for final report only, -1 for no report), optionally
             followed by a comma and the number of iterations between
@@ -119,6 +124,7 @@ Options
 )",
           prog_name(), help_ver_text, it_ctrl.get_max_iters(),
           it_ctrl.get_sig_digits(), it_ctrl.get_test_val(),
+          it_ctrl.get_accel_depth(), it_ctrl.get_num_threads(),
           it_ctrl.get_status_check_and_report_iters(),
           it_ctrl.get_status_check_only_iters());
 }
@@ -132,7 +138,7 @@ void pf_opts::process_command_line(int argc, char **argv)
 
   handle_long_opts(argc, argv);
 
-  while ((c = getopt(argc, argv, ":hn:s:l:k:f:a:yE:z:o:")) != -1) {
+  while ((c = getopt(argc, argv, ":hn:s:l:k:f:a:yE:A:j:z:o:")) != -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -195,6 +201,16 @@ void pf_opts::process_command_line(int argc, char **argv)
       print_status_or_exit(it_ctrl.set_sig_digits(num), c);
       break;
 
+    case 'A':
+      print_status_or_exit(read_int(optarg, &num), c);
+      print_status_or_exit(it_ctrl.set_accel_depth(num), c);
+      break;
+
+    case 'j':
+      print_status_or_exit(read_int(optarg, &num), c);
+      print_status_or_exit(it_ctrl.set_num_threads(num), c);
+      break;
+
     default:
       error("unknown command line error");
     }
@@ -385,6 +401,7 @@ Status make_equal_edges(Geometry &base_geom, IterationControl it_ctrl,
   double test_val = it_ctrl.get_test_val();
 
   vector<Vec3d> offsets(verts.size()); // Vertex adjustments
+  AndersonAccel accel(it_ctrl.get_accel_depth());
 
   for (it_ctrl.start_iter_with_setup(); !it_ctrl.is_done();
        it_ctrl.next_iter()) {
@@ -415,6 +432,7 @@ Status make_equal_edges(Geometry &base_geom, IterationControl it_ctrl,
 
     // adjust vertices post-loop (skip setup iter as global values not set)
     if (!it_ctrl.is_setup_iter()) {
+      accel.update_offsets(verts, offsets, principal_verts);
       for (int v_idx : principal_verts) {
         auto vert = verts[v_idx] + offsets[v_idx];
         to_ellipsoid(vert, ellipsoid);
@@ -525,6 +543,7 @@ Status make_regular_faces(Geometry &base_geom, IterationControl it_ctrl,
   }
 
   vector<Vec3d> offsets(verts.size()); // Vertex adjustments
+  AndersonAccel accel(it_ctrl.get_accel_depth());
 
   for (it_ctrl.start_iter(); !it_ctrl.is_done(); it_ctrl.next_iter()) {
     std::fill(offsets.begin(), offsets.end(), Vec3d::zero);
@@ -565,6 +584,17 @@ Status make_regular_faces(Geometry &base_geom, IterationControl it_ctrl,
       offsets[edge[1]] += 2 * offset;
     }
 
+    // the test value is from the plain adjustments, accelerate afterwards
+    if (it_ctrl.is_status_check_iter()) {
+      max_diff2 = 0;
+      for (auto &offset : offsets) {
+        double diff2 = offset.len2();
+        if (diff2 > max_diff2)
+          max_diff2 = diff2;
+      }
+    }
+    accel.update_offsets(verts, offsets, principal_verts);
+
     // adjust vertices post-loop
     if (using_symmetry) {
       // adjust principal vertices
@@ -580,14 +610,6 @@ Status make_regular_faces(Geometry &base_geom, IterationControl it_ctrl,
 
     string finish_msg;
     if (it_ctrl.is_status_check_iter()) {
-
-      max_diff2 = 0;
-      for (auto &offset : offsets) {
-        double diff2 = offset.len2();
-        if (diff2 > max_diff2)
-          max_diff2 = diff2;
-      }
-
       double width = BoundBox(verts).max_width();
       if (sqrt(max_diff2) / width < test_val) {
         it_ctrl.set_finished();
@@ -641,7 +663,8 @@ int main(int argc, char *argv[])
 
   Symmetry sym;
   if (opts.use_symmetry)
-    opts.print_status_or_exit(sym.init(geom), 'y');
+    opts.print_status_or_exit(
+        sym.init(geom, nullptr, opts.it_ctrl.get_num_threads()), 'y');
 
   if (geom.faces().size() == 0)
     opts.warning("no face date in input, no iterative processing will occur");
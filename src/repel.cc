@@ -43,12 +43,47 @@ using std::vector;
 
 using namespace anti;
 
+// Octree of points, used to approximate the forces from distant groups
+// of points (Barnes-Hut). Each node holds a range of the point order and
+// the centroid of those points.
+class PointOctree {
+public:
+  static const int min_approx_pts = 500; // use exact forces below this
+  static const int max_leaf_pts = 8;     // don't divide nodes smaller
+  static const int max_depth = 32;       // for coincident points
+
+private:
+  struct Node {
+    Vec3d cent;       // centroid of the node points
+    double width;     // width of the node cube
+    int start;        // position of first point in pt_order
+    int end;          // position after last point in pt_order
+    int first_child;  // index of first child node, -1 for a leaf
+    int num_children; // child nodes are consecutive
+  };
+
+  const vector<Vec3d> &pts;
+  vector<Node> nodes;
+  vector<int> pt_order; // point index numbers, grouped by node
+  vector<int> pt_pos;   // position of each point in pt_order
+
+  void build_node(int n_idx, Vec3d box_cent, double half_width, int depth);
+
+public:
+  PointOctree(const vector<Vec3d> &points);
+
+  // The offset (sum of forces) on a point, from all the other points
+  Vec3d get_offset(int idx, double exp, double acc) const;
+};
+
 class rep_opts : public ProgramOpts {
 public:
   IterationControl it_ctrl;
   int num_pts = -1;
   double repel_formula_exp = 2;
   double shorten_by = -1;
+  double approx_acc = 0;
+  int num_threads = 1;
 
   string ifile;
   string ofile;
@@ -82,6 +117,12 @@ Options
   -n <itrs> maximum number of iterations, -1 for unlimited (default: %d)
   -s <perc> percentage to shorten the travel distance (default: adaptive)
   -r <exp>  repelling formula, 1/distance^exp (default: 2)
+  -a <acc>  approximate the forces from distant groups of points (Barnes-Hut),
+            a group acts as a single point when its width divided by its
+            distance is less than acc, suggest 0.5 (default: 0, exact). Exact
+            forces are used for fewer than %d points
+  -j <thds> number of threads to use to calculate the forces, 0 for the
+            number of processors (default: 1)
   -l <lim>  minimum change of distance/width_of_model to terminate, as 
                negative exponent (default: %d giving %.0e)
   -z <nums> number of iterations between status reports (implies termination
@@ -92,6 +133,7 @@ Options
 
 )",
           prog_name(), help_ver_text, it_ctrl.get_max_iters(),
+          PointOctree::min_approx_pts,
           it_ctrl.get_sig_digits(), it_ctrl.get_test_val(),
           it_ctrl.get_status_check_and_report_iters(),
           it_ctrl.get_status_check_only_iters());
@@ -106,7 +148,7 @@ void rep_opts::process_command_line(int argc, char **argv)
 
   handle_long_opts(argc, argv);
 
-  while ((c = getopt(argc, argv, ":hn:z:N:s:l:r:o:")) != -1) {
+  while ((c = getopt(argc, argv, ":hn:z:N:s:l:r:a:j:o:")) != -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -145,6 +187,18 @@ void rep_opts::process_command_line(int argc, char **argv)
                 c);
       break;
 
+    case 'a':
+      print_status_or_exit(read_double(optarg, &approx_acc), c);
+      if (approx_acc < 0)
+        error("accuracy cannot be negative", c);
+      break;
+
+    case 'j':
+      print_status_or_exit(read_int(optarg, &num_threads), c);
+      if (num_threads < 0)
+        error("number of threads cannot be negative", c);
+      break;
+
     case 'o':
       ofile = optarg;
       break;
@@ -174,6 +228,108 @@ Vec3d repel_inv_dist_exp(Vec3d v1, Vec3d v2, double exp)
   return v2.with_len(len);
 }
 
+PointOctree::PointOctree(const vector<Vec3d> &points)
+    : pts(points), pt_order(points.size()), pt_pos(points.size())
+{
+  for (unsigned int i = 0; i < pts.size(); i++)
+    pt_order[i] = i;
+
+  BoundBox bb(pts);
+  Vec3d half_diag = (bb.get_max() - bb.get_min()) / 2;
+  double half_width =
+      std::max(half_diag[0], std::max(half_diag[1], half_diag[2]));
+  nodes.push_back({Vec3d::zero, 0, 0, (int)pts.size(), -1, 0});
+  build_node(0, bb.get_centre(), half_width * (1 + 1e-9), 0);
+
+  for (unsigned int i = 0; i < pts.size(); i++)
+    pt_pos[pt_order[i]] = i;
+}
+
+void PointOctree::build_node(int n_idx, Vec3d box_cent, double half_width,
+                             int depth)
+{
+  const int start = nodes[n_idx].start;
+  const int end = nodes[n_idx].end;
+  Vec3d cent = Vec3d::zero;
+  for (int i = start; i < end; i++)
+    cent += pts[pt_order[i]];
+  nodes[n_idx].cent = cent / (end - start);
+  nodes[n_idx].width = 2 * half_width;
+  if (end - start <= max_leaf_pts || depth >= max_depth)
+    return;
+
+  // sort the points into octants
+  auto octant = [&](int pt_idx) {
+    const Vec3d &P = pts[pt_idx];
+    return (P[0] >= box_cent[0]) + 2 * (P[1] >= box_cent[1]) +
+           4 * (P[2] >= box_cent[2]);
+  };
+  int oct_start[9] = {0};
+  for (int i = start; i < end; i++)
+    oct_start[octant(pt_order[i]) + 1]++;
+  for (int i = 0; i < 8; i++)
+    oct_start[i + 1] += oct_start[i];
+  vector<int> sorted(end - start);
+  int oct_pos[8];
+  std::copy(oct_start, oct_start + 8, oct_pos);
+  for (int i = start; i < end; i++)
+    sorted[oct_pos[octant(pt_order[i])]++] = pt_order[i];
+  std::copy(sorted.begin(), sorted.end(), pt_order.begin() + start);
+
+  // make the child nodes for non-empty octants consecutively, then build
+  const int first_child = nodes.size();
+  vector<int> child_octs;
+  for (int i = 0; i < 8; i++) {
+    if (oct_start[i + 1] > oct_start[i]) {
+      nodes.push_back({Vec3d::zero, 0, start + oct_start[i],
+                       start + oct_start[i + 1], -1, 0});
+      child_octs.push_back(i);
+    }
+  }
+  nodes[n_idx].first_child = first_child;
+  nodes[n_idx].num_children = child_octs.size();
+
+  const double q_width = half_width / 2;
+  for (unsigned int i = 0; i < child_octs.size(); i++) {
+    const int oct = child_octs[i];
+    Vec3d child_cent = box_cent + Vec3d((oct & 1) ? q_width : -q_width,
+                                        (oct & 2) ? q_width : -q_width,
+                                        (oct & 4) ? q_width : -q_width);
+    build_node(first_child + i, child_cent, q_width, depth + 1);
+  }
+}
+
+Vec3d PointOctree::get_offset(int idx, double exp, double acc) const
+{
+  const Vec3d &P = pts[idx];
+  const int pos = pt_pos[idx];
+  const double acc2 = acc * acc;
+  Vec3d offset = Vec3d::zero;
+
+  int stack[8 * max_depth + 8];
+  int stack_sz = 0;
+  stack[stack_sz++] = 0;
+  while (stack_sz) {
+    const Node &node = nodes[stack[--stack_sz]];
+    const bool contains_pt = (pos >= node.start && pos < node.end);
+    if (node.first_child < 0) { // leaf, use exact forces
+      for (int i = node.start; i < node.end; i++)
+        if (i != pos)
+          offset -= repel_inv_dist_exp(P, pts[pt_order[i]], exp);
+    }
+    else if (!contains_pt &&
+             node.width * node.width < acc2 * (node.cent - P).len2())
+      offset -= repel_inv_dist_exp(P, node.cent, exp) *
+                (double)(node.end - node.start);
+    else {
+      for (int i = 0; i < node.num_children; i++)
+        stack[stack_sz++] = node.first_child + i;
+    }
+  }
+
+  return offset;
+}
+
 void random_placement(Geometry &geom, int n)
 {
   geom.clear_all();
@@ -183,8 +339,25 @@ void random_placement(Geometry &geom, int n)
     geom.add_vert(Vec3d::random(rnd).unit());
 }
 
+// Divide the rows of the pair loop into parts with a similar number
+// of pairs
+static vector<int> get_pair_row_starts(int v_sz, int num_parts)
+{
+  vector<int> row_starts(num_parts + 1, v_sz);
+  row_starts[0] = 0;
+  const double pairs_per_part = (double)v_sz * (v_sz - 1) / 2 / num_parts;
+  double pairs_cnt = 0;
+  int part = 1;
+  for (int i = 0; i < v_sz && part < num_parts; i++) {
+    pairs_cnt += v_sz - 1 - i;
+    if (pairs_cnt >= part * pairs_per_part)
+      row_starts[part++] = i + 1;
+  }
+  return row_starts;
+}
+
 void repel(Geometry &geom, IterationControl it_ctrl, double exponent,
-           double shorten_factor)
+           double shorten_factor, double approx_acc, int num_threads)
 {
   const int v_sz = geom.verts().size();
   vector<int> wts(v_sz);
@@ -193,6 +366,16 @@ void repel(Geometry &geom, IterationControl it_ctrl, double exponent,
     wts[i] = col.is_index() ? col.get_index() : 1;
   }
   vector<Vec3d> offsets(v_sz);
+
+  // Each part of the pair loop accumulates into its own offsets, which
+  // are then summed in part order, so a given number of threads always
+  // gives the same result
+  ThreadPool pool(num_threads);
+  const int num_parts = pool.get_num_threads();
+  const vector<int> row_starts = get_pair_row_starts(v_sz, num_parts);
+  vector<vector<Vec3d>> part_offsets;
+  if (num_parts > 1)
+    part_offsets.resize(num_parts, vector<Vec3d>(v_sz));
   double dist2, max_dist2 = 0;
   double last_av_max_dist2 = 0, max_dist2_sum = 0;
   bool adaptive = false;
@@ -210,12 +393,42 @@ void repel(Geometry &geom, IterationControl it_ctrl, double exponent,
     std::fill(offsets.begin(), offsets.end(), Vec3d::zero);
     max_dist2 = 0;
 
-    for (int i = 0; i < v_sz - 1; i++) {
-      for (int j = i + 1; j < v_sz; j++) {
-        Vec3d offset =
-            repel_inv_dist_exp(geom.verts(i), geom.verts(j), exponent);
-        offsets[i] -= offset;
-        offsets[j] += offset;
+    if (approx_acc > 0 && v_sz >= PointOctree::min_approx_pts) {
+      PointOctree octree(geom.verts());
+      pool.run(num_parts, [&](int part) {
+        const int end = part_start(v_sz, num_parts, part + 1);
+        for (int i = part_start(v_sz, num_parts, part); i < end; i++)
+          offsets[i] = octree.get_offset(i, exponent, approx_acc);
+      });
+    }
+    else if (num_parts > 1) {
+      pool.run(num_parts, [&](int part) {
+        vector<Vec3d> &offs = part_offsets[part];
+        std::fill(offs.begin(), offs.end(), Vec3d::zero);
+        for (int i = row_starts[part]; i < row_starts[part + 1]; i++) {
+          for (int j = i + 1; j < v_sz; j++) {
+            Vec3d offset =
+                repel_inv_dist_exp(geom.verts(i), geom.verts(j), exponent);
+            offs[i] -= offset;
+            offs[j] += offset;
+          }
+        }
+      });
+      pool.run(num_parts, [&](int part) {
+        const int end = part_start(v_sz, num_parts, part + 1);
+        for (int i = part_start(v_sz, num_parts, part); i < end; i++)
+          for (int p = 0; p < num_parts; p++)
+            offsets[i] += part_offsets[p][i];
+      });
+    }
+    else {
+      for (int i = 0; i < v_sz - 1; i++) {
+        for (int j = i + 1; j < v_sz; j++) {
+          Vec3d offset =
+              repel_inv_dist_exp(geom.verts(i), geom.verts(j), exponent);
+          offsets[i] -= offset;
+          offsets[j] += offset;
+        }
       }
     }
 
@@ -297,7 +510,8 @@ int main(int argc, char *argv[])
   else
     opts.read_or_error(geom, opts.ifile);
 
-  repel(geom, opts.it_ctrl, opts.repel_formula_exp, opts.shorten_by / 100);
+  repel(geom, opts.it_ctrl, opts.repel_formula_exp, opts.shorten_by / 100,
+        opts.approx_acc, opts.num_threads);
 
   opts.write_or_error(geom, opts.ofile);
 
@@ -32,6 +32,7 @@
 #include "color_common.h"
 #include "lat_util_common.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib> // avoid ambiguities with std::abs(long) on OSX
 #include <string>
@@ -81,6 +82,8 @@ public:
   int method = 1;             // 1 - sphere-ray intersection  2 - z guess
   long scale = 0;             // for precision
   bool tester_defeat = false; // turn off computation testing for method 1
+  bool use_symmetry = false;  // only cast rays in the fundamental region
+  int num_threads = 1;        // threads for sphere-ray method
 
   bool convex_hull = true; // do convex hull of result
   bool add_hull = false;   // add lattice to convex hull
@@ -125,6 +128,12 @@ Program Options
   -M <mthd> 1 - sphere-ray intersection  2 - z guess (default: 1)
   -f        fill interior points (not for -C c)
   -t        defeat computational error testing for sphere-ray method
+  -s        use symmetry, for sphere-ray method with lattice centred on the
+            origin and convex hull only (-C c). Only cast rays in one part
+            of the lattice and repeat the points that could be hull vertices
+            by the octahedral symmetry (vertex order differs from default)
+  -j <thds> number of threads for sphere-ray method, 0 for the number of
+            processors (default: 1)
 
 Scene Options
   -C <opt>  c - convex hull only, i - keep interior, s - suppress (default: c)
@@ -181,7 +190,7 @@ void waterman_opts::process_command_line(int argc, char **argv)
 
   handle_long_opts(argc, argv);
 
-  while ((c = getopt(argc, argv, ":hr:q:M:ftvC:V:E:F:T:m:Z:l:o:")) != -1) {
+  while ((c = getopt(argc, argv, ":hr:q:M:ftsj:vC:V:E:F:T:m:Z:l:o:")) != -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -241,6 +250,16 @@ void waterman_opts::process_command_line(int argc, char **argv)
       tester_defeat = true;
       break;
 
+    case 's':
+      use_symmetry = true;
+      break;
+
+    case 'j':
+      print_status_or_exit(read_int(optarg, &num_threads), c);
+      if (num_threads < 0)
+        error("number of threads cannot be negative", c);
+      break;
+
     case 'v':
       verbose = true;
       break;
@@ -399,6 +418,16 @@ void waterman_opts::process_command_line(int argc, char **argv)
     fill = false;
   }
 
+  if (use_symmetry) {
+    if (method != 1)
+      error("symmetry can only be used with the sphere-ray method", 's');
+    if (!origin_based)
+      error("symmetry can only be used with the lattice centred on the origin",
+            's');
+    if (!convex_hull || add_hull)
+      error("symmetry can only be used with convex hull only (-C c)", 's');
+  }
+
   if (tester_defeat) {
     if (method == 1)
       warning("computational error testing has been disabled!");
@@ -610,6 +639,118 @@ void refine_z_vals(long &z_near, long &z_far, const long x, const long y,
 // Separate function to contain protability problems with abs(long)
 long long_abs(long val) { return std::abs((long)val); }
 
+// Find the outer points on the ray through x, y, z_near and z_far are
+// modified, and are set to an invalid value if there is no valid point
+bool sphere_ray_outer_z(long &z_near, long &z_far, const long x, const long y,
+                        const waterman_opts &opts, const bool cent_z_int,
+                        const vector<long> &i_center, const long long i_R2,
+                        long &errors, long &misses)
+{
+  // faster miss determination, but using for false miss detection
+  bool miss = true;
+  long long xy_contribution = ((long long)x * opts.scale - i_center[0]) *
+                                  (x * opts.scale - i_center[0]) +
+                              ((long long)y * opts.scale - i_center[1]) *
+                                  (y * opts.scale - i_center[1]);
+  if (inside_exact(i_center[2], i_center[2], xy_contribution, i_R2))
+    miss = false;
+
+  if (!sphere_ray_z_intersect_points(
+          z_near, z_far, x, y, opts.origin_based, opts.center[0],
+          opts.center[1], opts.center[2], opts.R_squared, opts.eps)) {
+    // fprintf(stderr,"Ray missed the Sphere\n");
+    if (!miss) {
+      // if (verbose)
+      //   fprintf(stderr,"error: at x = %ld, y = %ld, a false miss
+      //   happened\n",x,y);
+      misses++;
+    }
+    return false;
+  }
+
+  // ray tangent points are never on integer when z of center is not on
+  // integer value
+  // NEEDS MORE TESTING
+  if (!cent_z_int && z_near == z_far)
+    return false;
+
+  if (opts.lattice_type != 0) { // lattice type is not equal to SC (type = 0)
+    // if z_near is not on the lattice then find if a point 1 layer deeper
+    // is on the lattice
+    if (!valid_point(opts.lattice_type, long_abs(x), long_abs(y),
+                     long_abs(z_near))) {
+      // if it is a tangent point, there is no valid deeper coordinate. It
+      // was on "zero" already.
+      // if bcc and z_near-1 is invalid then there is no valid z point
+      // (z_far+1 will be invalid as well)
+      if (z_near == z_far ||
+          (opts.lattice_type == 2 &&
+           !valid_point(opts.lattice_type, long_abs(x), long_abs(y),
+                        long_abs(z_near - 1))))
+        return false;
+      else
+        z_near--;
+    }
+    // if still in the loop, z_far is only advanced if on invalid point
+    if (!valid_point(opts.lattice_type, long_abs(x), long_abs(y),
+                     long_abs(z_far)))
+      z_far++;
+  }
+
+  // uncommenting next 2 lines forces errors
+  // z_near += 5;
+  // z_far += 5;
+  if (!opts.tester_defeat && opts.scale) {
+    long z_near2 = z_near;
+    long z_far2 = z_far;
+    refine_z_vals(z_near2, z_far2, x, y, opts.lattice_type, opts.scale,
+                  i_center, i_R2);
+
+    if (z_near2 != z_near) {
+      errors++;
+      // if (verbose)
+      //   fprintf(stderr, "(%ld, %ld) z_near %ld -> %s\n", x, y, z_near,
+      //          (z_near2!=LONG_MAX) ? itostr(z_near2).c_str() :
+      //          "invalid");
+      z_near = z_near2;
+    }
+
+    if (z_far2 != z_far) {
+      errors++;
+      // if (verbose)
+      //   fprintf(stderr, "(%ld, %ld) z_far %ld -> %s\n", x, y, z_far,
+      //          (z_far2!=LONG_MAX) ? itostr(z_far2).c_str() :
+      //          "invalid");
+      z_far = z_far2;
+    }
+  }
+
+  return true;
+}
+
+// Add the images of a point under the symmetry group of the cube
+void add_octahedral_images(vector<Vec3d> &verts, long x, long y, long z)
+{
+  long crds[3] = {z, y, x}; // in ascending order, for next_permutation
+  std::sort(crds, crds + 3);
+  do {
+    for (int signs = 0; signs < 8; signs++) {
+      bool valid = true;
+      long pt[3];
+      for (int i = 0; i < 3; i++) {
+        const bool neg = signs & (1 << i);
+        if (neg && crds[i] == 0) { // -0 is not a separate image
+          valid = false;
+          break;
+        }
+        pt[i] = neg ? -crds[i] : crds[i];
+      }
+      if (valid)
+        verts.push_back(Vec3d(pt[0], pt[1], pt[2]));
+    }
+  } while (std::next_permutation(crds, crds + 3));
+}
+
 void sphere_ray_waterman(Geometry &geom, const waterman_opts &opts)
 {
   vector<Vec3d> &verts = geom.raw_verts();
@@ -627,6 +768,10 @@ void sphere_ray_waterman(Geometry &geom, const waterman_opts &opts)
   long rad_bottom_y = (long)ceil(opts.center[1] - opts.radius);
   long rad_top_y = (long)floor(opts.center[1] + opts.radius);
 
+  // With symmetry, only cast rays in the region 0 <= y <= x
+  if (opts.use_symmetry)
+    rad_bottom_y = 0;
+
   vector<long> i_center(3);
   for (int i = 0; i < 3; i++)
     i_center[i] = (long)floor(opts.center[i] * opts.scale + 0.5);
@@ -634,102 +779,59 @@ void sphere_ray_waterman(Geometry &geom, const waterman_opts &opts)
   long long i_R2 = (long long)floor(
       opts.radius * opts.radius * opts.scale * opts.scale + 0.5);
 
-  long z_near = 0;
-  long z_far = 0;
-
-  long total_errors = 0;
-  long total_misses = 0;
-
-  for (long y = rad_bottom_y; y <= rad_top_y; y++) {
-    for (long x = rad_left_x; x <= rad_right_x; x++) {
-      // faster miss determination, but using for false miss detection
-      bool miss = true;
-      long long xy_contribution = ((long long)x * opts.scale - i_center[0]) *
-                                      (x * opts.scale - i_center[0]) +
-                                  ((long long)y * opts.scale - i_center[1]) *
-                                      (y * opts.scale - i_center[1]);
-      if (inside_exact(i_center[2], i_center[2], xy_contribution, i_R2))
-        miss = false;
-      // continue;
-
-      if (!sphere_ray_z_intersect_points(
-              z_near, z_far, x, y, opts.origin_based, opts.center[0],
-              opts.center[1], opts.center[2], opts.R_squared, opts.eps)) {
-        // fprintf(stderr,"Ray missed the Sphere\n");
-        if (!miss) {
-          // if (verbose)
-          //   fprintf(stderr,"error: at x = %ld, y = %ld, a false miss
-          //   happened\n",x,y);
-          total_misses++;
-        }
-        continue;
-      }
-
-      // ray tangent points are never on integer when z of center is not on
-      // integer value
-      // NEEDS MORE TESTING
-      if (!cent_z_int && z_near == z_far)
-        continue;
-
-      if (opts.lattice_type !=
-          0) { // lattice type is not equal to SC (type = 0)
-        // if z_near is not on the lattice then find if a point 1 layer deeper
-        // is on the lattice
-        if (!valid_point(opts.lattice_type, long_abs(x), long_abs(y),
-                         long_abs(z_near))) {
-          // if it is a tangent point, there is no valid deeper coordinate. It
-          // was on "zero" already.
-          // if bcc and z_near-1 is invalid then there is no valid z point
-          // (z_far+1 will be invalid as well)
-          if (z_near == z_far ||
-              (opts.lattice_type == 2 &&
-               !valid_point(opts.lattice_type, long_abs(x), long_abs(y),
-                            long_abs(z_near - 1))))
-            continue;
-          else
-            z_near--;
-        }
-        // if still in the loop, z_far is only advanced if on invalid point
-        if (!valid_point(opts.lattice_type, long_abs(x), long_abs(y),
-                         long_abs(z_far)))
-          z_far++;
-      }
-
-      // uncommenting next 2 lines forces errors
-      // z_near += 5;
-      // z_far += 5;
-      if (!opts.tester_defeat && opts.scale) {
-        long z_near2 = z_near;
-        long z_far2 = z_far;
-        refine_z_vals(z_near2, z_far2, x, y, opts.lattice_type, opts.scale,
-                      i_center, i_R2);
+  // Rows of rays are divided into consecutive parts, and each part is
+  // processed into its own buffer, which are joined in row order
+  ThreadPool pool(opts.num_threads);
+  const int num_rows = rad_top_y - rad_bottom_y + 1;
+  const int num_parts = std::max(std::min(pool.get_num_threads(), num_rows), 1);
+  vector<vector<Vec3d>> part_verts(num_parts);
+  vector<long> part_errors(num_parts, 0);
+  vector<long> part_misses(num_parts, 0);
+  pool.run(num_parts, [&](int part) {
+    const long y_end = rad_bottom_y + part_start(num_rows, num_parts, part + 1);
+    for (long y = rad_bottom_y + part_start(num_rows, num_parts, part);
+         y < y_end; y++) {
+      long x_start = (opts.use_symmetry) ? std::max(y, rad_left_x) : rad_left_x;
+      for (long x = x_start; x <= rad_right_x; x++) {
+        long z_near = 0;
+        long z_far = 0;
+        if (!sphere_ray_outer_z(z_near, z_far, x, y, opts, cent_z_int,
+                                i_center, i_R2, part_errors[part],
+                                part_misses[part]))
+          continue;
 
-        if (z_near2 != z_near) {
-          total_errors++;
-          // if (verbose)
-          //   fprintf(stderr, "(%ld, %ld) z_near %ld -> %s\n", x, y, z_near,
-          //          (z_near2!=LONG_MAX) ? itostr(z_near2).c_str() :
-          //          "invalid");
-          z_near = z_near2;
+        if (opts.use_symmetry) {
+          // keep the point if it is in the region 0 <= z <= y <= x, this
+          // includes a representative of every vertex of the hull
+          if (z_near != std::numeric_limits<long>::max() && z_near >= 0 &&
+              z_near <= y)
+            part_verts[part].push_back(Vec3d(x, y, z_near));
+          continue;
         }
 
-        if (z_far2 != z_far) {
-          total_errors++;
-          // if (verbose)
-          //   fprintf(stderr, "(%ld, %ld) z_far %ld -> %s\n", x, y, z_far,
-          //          (z_far2!=LONG_MAX) ? itostr(z_far2).c_str() :
-          //          "invalid");
-          z_far = z_far2;
-        }
+        // don't write invalid points
+        if (z_near != std::numeric_limits<long>::max())
+          part_verts[part].push_back(Vec3d(x, y, z_near));
+        if (z_far != std::numeric_limits<long>::max() &&
+            z_near != z_far) // don't rewrite tangent point
+          part_verts[part].push_back(Vec3d(x, y, z_far));
       }
+    }
+  });
 
-      // don't write invalid points
-      if (z_near != std::numeric_limits<long>::max())
-        verts.push_back(Vec3d(x, y, z_near));
-      if (z_far != std::numeric_limits<long>::max() &&
-          z_near != z_far) // don't rewrite tangent point
-        verts.push_back(Vec3d(x, y, z_far));
+  long total_errors = 0;
+  long total_misses = 0;
+  for (int part = 0; part < num_parts; part++) {
+    if (opts.use_symmetry) {
+      for (const auto &v : part_verts[part])
+        add_octahedral_images(verts, lround(v[0]), lround(v[1]), lround(v[2]));
     }
+    else
+      verts.insert(verts.end(), part_verts[part].begin(),
+                   part_verts[part].end());
+    vector<Vec3d>().swap(part_verts[part]); // free the memory
+    total_errors += part_errors[part];
+    total_misses += part_misses[part];
   }
 
   if (opts.verbose && !opts.tester_defeat)
@@ -56,6 +56,7 @@ public:
   TilingColoring col_type;
   Coloring clrngs[3];
   bool quiet = false;
+  int num_threads = 1;
   string ifile;
   string ofile;
 
@@ -110,6 +111,8 @@ Options
   -u        output only one example of each type of tile (one per path)
   -a        add the 'meta'-transformed base
   -f <ht>   lift the face centres by this height
+  -j <thds> number of threads to use to find the tiles, 0 for the number
+            of processors (default: 1)
   -q        quiet, don't print report
   -o <file> write output to file (default: write to standard output)
 
@@ -125,7 +128,7 @@ void wy_opts::process_command_line(int argc, char **argv)
 
   handle_long_opts(argc, argv);
 
-  while ((c = getopt(argc, argv, ":ho:p:c:f:Rr:MC:m:uqa")) != -1) {
+  while ((c = getopt(argc, argv, ":ho:p:c:f:Rr:MC:m:uqaj:")) != -1) {
     if (common_opts(c, optopt))
       continue;
 
@@ -166,6 +169,12 @@ void wy_opts::process_command_line(int argc, char **argv)
       print_status_or_exit(read_double(optarg, &face_ht), c);
       break;
 
+    case 'j':
+      print_status_or_exit(read_int(optarg, &num_threads), c);
+      if (num_threads < 0)
+        error("number of threads cannot be negative", c);
+      break;
+
     case 'C':
       print_status_or_exit(col_type.read_coloring(optarg), c);
       break;
@@ -236,8 +245,11 @@ int main(int argc, char *argv[])
     opts.warning("base polyhedron is not oriented: reverse has no effect", 'R');
   }
 
-  if (!orientable)
+  if (!orientable) {
     tiling.start_everywhere();
+    tiling.set_merge_doubled_tiles();
+  }
+  tiling.set_num_threads(opts.num_threads);
 
   Status stat = tiling.set_geom(geom, opts.input_is_meta, opts.face_ht);
   if (stat.is_error())
@@ -246,8 +258,6 @@ int main(int argc, char *argv[])
   Geometry ogeom;
   vector<Tile::TileReport> tile_reports;
   opts.print_status_or_exit(tiling.make_tiling(ogeom, &tile_reports));
-  if (!orientable)
-    merge_coincident_elements(ogeom, "f");
 
   if (!opts.quiet) {
     fprintf(stderr, "\n");
@@ -457,7 +457,7 @@ static void reverse_odd_faces(Geometry &geom)
   const int f_sz = geom.faces().size();
   for (int i = 0; i < f_sz; i++)
     if (i % 2)
-      reverse(geom.faces(i).begin(), geom.faces(i).end());
+      reverse(geom.raw_faces(i).begin(), geom.raw_faces(i).end());
 }
 
 bool weave::set_geom(const Geometry &geom, double face_ht)